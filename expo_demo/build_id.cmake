@@ -0,0 +1,52 @@
+# Build ID header
+#
+# persist.c stamps the tables and calibration it saves to flash with an ID of
+# the build, so a new build builds and measures them again. A stamp taken at
+# compile time (__DATE__ and __TIME__) only changes when the file using it is
+# recompiled, so instead a step run on every build hashes every expo_demo
+# source along with the target's compile definitions into build_id.h. The
+# header is only rewritten when the hash changes, so an unchanged tree doesn't
+# rebuild anything.
+#
+# expo_demo_build_id(target) adds the step for a target that compiles
+# persist.c. Run with -P, this file writes the header.
+
+if(CMAKE_SCRIPT_MODE_FILE)
+    file(GLOB sources
+        ${SOURCE_DIR}/*.c
+        ${SOURCE_DIR}/*.h
+        ${SOURCE_DIR}/*.cmake
+        ${SOURCE_DIR}/CMakeLists.txt
+    )
+    list(SORT sources)
+    set(digests "${DEFINITIONS}")
+    foreach(source ${sources})
+        file(SHA256 ${source} digest)
+        string(APPEND digests ${digest})
+    endforeach()
+    string(SHA256 id "${digests}")
+    string(SUBSTRING ${id} 0 8 id)
+
+    file(WRITE ${OUT}.tmp "// Generated by build_id.cmake\n#define BUILD_ID 0x${id}u\n")
+    execute_process(COMMAND ${CMAKE_COMMAND} -E copy_if_different ${OUT}.tmp ${OUT})
+    file(REMOVE ${OUT}.tmp)
+    return()
+endif()
+
+set(BUILD_ID_SCRIPT ${CMAKE_CURRENT_LIST_FILE})
+
+function(expo_demo_build_id target)
+    get_filename_component(source_dir ${BUILD_ID_SCRIPT} DIRECTORY)
+    set(dir ${CMAKE_CURRENT_BINARY_DIR}/${target}_build_id)
+    add_custom_target(${target}_build_id
+        COMMAND ${CMAKE_COMMAND}
+            -DSOURCE_DIR=${source_dir}
+            "-DDEFINITIONS=$<JOIN:$<TARGET_PROPERTY:${target},COMPILE_DEFINITIONS>, >"
+            -DOUT=${dir}/build_id.h
+            -P ${BUILD_ID_SCRIPT}
+        BYPRODUCTS ${dir}/build_id.h
+        VERBATIM
+    )
+    add_dependencies(${target} ${target}_build_id)
+    target_include_directories(${target} PRIVATE ${dir})
+endfunction()
@@ -0,0 +1,172 @@
+#include "calibrate.h"
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "hardware/sync.h"
+#include "video_mode.h"
+#include "params.h"
+#include "effects.h"
+#include "frame.h"
+#include "governor.h"
+#include "regions.h"
+#include "symmetry.h"
+#include "telemetry.h"
+#include "persist.h"
+#include <string.h>
+
+// Frames drawn for each demo and level, and about how many lines of each
+// (taller modes draw pairs of lines spread down the screen, so the line
+// repeat of the cheapest level is measured too)
+#define CALIBRATE_FRAMES 3
+#define CALIBRATE_LINES 120
+
+// Headroom a level needs to count as sustainable. Drawing off screen misses
+// the bus traffic of scanvideo itself, so this is above the governor's own
+// step-down threshold
+#define CALIBRATE_HEADROOM_PCT 20
+
+// Table stored at the start of the last flash sector
+#define CALIBRATE_FLASH_OFFSET (PICO_FLASH_SIZE_BYTES - FLASH_SECTOR_SIZE)
+#define CALIBRATE_MAGIC 0x4c434243 // "CBCL"
+
+typedef struct {
+    uint32_t magic;
+    uint32_t stamp;
+    uint8_t levels[DEMO_COUNT];
+    uint8_t sum;
+} calibration_t;
+
+static_assert(sizeof(calibration_t) <= FLASH_PAGE_SIZE, "calibration is programmed as one page");
+
+// Identifies the firmware and video mode the table was measured with, so
+// flashing a new build measures again
+static uint32_t build_stamp(void) {
+    return (persist_build_stamp() ^ DEMO_COUNT) * 16777619u;
+}
+
+static uint8_t levels_sum(const uint8_t *levels) {
+    uint8_t sum = 0;
+    for(uint demo = 0; demo < DEMO_COUNT; demo++) {
+        sum += levels[demo];
+    }
+    return sum;
+}
+
+static bool load(void) {
+    const calibration_t *saved = (const calibration_t *)(XIP_BASE + CALIBRATE_FLASH_OFFSET);
+    if(saved->magic != CALIBRATE_MAGIC || saved->stamp != build_stamp() || saved->sum != levels_sum(saved->levels)) {
+        return false;
+    }
+    for(uint demo = 0; demo < DEMO_COUNT; demo++) {
+        if(saved->levels[demo] < RESOLUTION_FULL || saved->levels[demo] >= RESOLUTION_COUNT) {
+            return false;
+        }
+    }
+    memcpy(governor_demo_levels, saved->levels, DEMO_COUNT);
+    return true;
+}
+
+static void save(void) {
+    static uint8_t page[FLASH_PAGE_SIZE];
+    memset(page, 0xff, sizeof(page));
+    calibration_t *table = (calibration_t *)page;
+    table->magic = CALIBRATE_MAGIC;
+    table->stamp = build_stamp();
+    memcpy(table->levels, governor_demo_levels, DEMO_COUNT);
+    table->sum = levels_sum(table->levels);
+
+    // Nothing may run from flash while it is written (core 1 has not started yet)
+    uint32_t interrupts = save_and_disable_interrupts();
+    flash_range_erase(CALIBRATE_FLASH_OFFSET, FLASH_SECTOR_SIZE);
+    flash_range_program(CALIBRATE_FLASH_OFFSET, page, FLASH_PAGE_SIZE);
+    restore_interrupts(interrupts);
+}
+
+static void stage(uint8_t id, uint16_t value) {
+    param_update_t update = {id, value};
+    params_stage(&update, 1);
+}
+
+// Slowest line of one demo at one fixed level, drawn through the same per-frame
+// steps as core 1 (and core 0's effect stepping) into two off-screen buffers
+static uint32_t measure(uint8_t demo, uint8_t level) {
+    static uint32_t data[2][PICO_SCANVIDEO_MAX_SCANLINE_BUFFER_WORDS];
+    static scanvideo_scanline_buffer_t buffers[2];
+
+    stage(PARAM_DEMO, demo);
+    stage(PARAM_RESOLUTION, level);
+
+    uint16_t height = vga_mode.height;
+    uint16_t stride = MAX(height / CALIBRATE_LINES, 1);
+    uint32_t slowest = 0;
+    for(uint frame = 0; frame < CALIBRATE_FRAMES; frame++) {
+        effects_poll();
+        frame_begin(false);
+
+        const scanvideo_scanline_buffer_t *previous = NULL;
+        for(uint16_t y = 0; y < height; y++) {
+            if((y >> 1) % stride) {
+                continue;
+            }
+            scanvideo_scanline_buffer_t *buffer = &buffers[y & 1];
+            buffer->data = data[y & 1];
+            buffer->data_max = PICO_SCANVIDEO_MAX_SCANLINE_BUFFER_WORDS;
+            buffer->scanline_id = (frame << 16) | y;
+
+            uint32_t line_start = time_us_32();
+            frame_draw_line(buffer, previous);
+            uint32_t us = time_us_32() - line_start;
+            telemetry_line(us);
+            slowest = MAX(slowest, us);
+            previous = buffer;
+        }
+
+        // Publish the frame's line times (effects stepped on core 0 move on
+        // with wall_frame, which frame_begin has already advanced)
+        telemetry_end_frame();
+    }
+    return slowest;
+}
+
+void calibrate_init(void) {
+    if(load()) {
+        return;
+    }
+
+    telemetry_init();
+    uint32_t budget = render_stats.line_budget_us;
+    uint32_t limit = budget - budget * CALIBRATE_HEADROOM_PCT / 100;
+
+    // Measure the demos full screen with nothing on top
+    uint16_t demo = param(PARAM_DEMO);
+    uint16_t layout = param(PARAM_LAYOUT);
+    uint16_t osd = param(PARAM_OSD);
+    uint16_t symmetry = param(PARAM_SYMMETRY);
+    uint16_t resolution = param(PARAM_RESOLUTION);
+    stage(PARAM_LAYOUT, LAYOUT_FULL);
+    stage(PARAM_OSD, 0);
+    stage(PARAM_SYMMETRY, SYMMETRY_NONE);
+
+    // Richest level whose slowest line fits, or the cheapest level if none
+    // does. Demos too wide for the scanline buffer are left blank, so are not
+    // drawn (and the entry is never used)
+    for(uint d = 0; d < DEMO_COUNT; d++) {
+        if(!governor_demo_fit[d]) {
+            governor_demo_levels[d] = RESOLUTION_FULL;
+            continue;
+        }
+        uint8_t level = RESOLUTION_FULL;
+        while(level < RESOLUTION_HALF_BOTH && measure(d, level) > limit) {
+            level++;
+        }
+        governor_demo_levels[d] = level;
+    }
+
+    stage(PARAM_DEMO, demo);
+    stage(PARAM_LAYOUT, layout);
+    stage(PARAM_OSD, osd);
+    stage(PARAM_SYMMETRY, symmetry);
+    stage(PARAM_RESOLUTION, resolution);
+    params_apply_pending();
+
+    save();
+}
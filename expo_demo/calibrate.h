@@ -0,0 +1,22 @@
+// Start-up calibration of the resolution governor
+//
+// Every demo is drawn off screen for a few hundred lines at each governor
+// level through the normal frame pipeline, timing each line against the line
+// budget. The richest level with enough headroom becomes the demo's entry in
+// governor_demo_levels, so automatic mode starts there instead of stepping
+// down from full resolution after lines go late.
+//
+// The table is saved to the last sector of flash with a stamp of the build and
+// video mode, and later boots of the same firmware load it instead of
+// measuring again.
+
+#ifndef CALIBRATE_H
+#define CALIBRATE_H
+
+#include "pico.h"
+
+// Load the saved table, or measure every demo and save it (core 0, after
+// effects_init and governor_init, and before core 1 starts or USB is set up)
+void calibrate_init(void);
+
+#endif
@@ -0,0 +1,252 @@
+#include "control.h"
+#include "params.h"
+#include "param_proto.h"
+#include "trace.h"
+#include "telemetry.h"
+#include "persist.h"
+#include "wall.h"
+#include "pico/stdlib.h"
+#include "hardware/adc.h"
+#include <math.h>
+
+// How often the pots are sampled
+#define POT_POLL_US 1000
+
+static param_decoder_t usb_decoder;
+static uint32_t last_pot_poll;
+
+// Last value each parameter was given by a pot (pot only overrides USB when it moves)
+static uint16_t pot_value[PARAM_COUNT];
+
+// Latest raw readings, live or replayed
+static uint16_t pot_readings[2];
+
+static trace_t trace;
+static uint8_t trace_mode;
+static uint8_t trace_param;
+static uint32_t trace_frame;
+
+// Functions to map potentiometer input to speed of animated demos
+static uint16_t speedFrame(uint16_t pot_raw) {
+    uint8_t pot = round(4 * (float)pot_raw / (1 << 12));
+
+    switch(pot) {
+        case 1:
+            // 1.5x speed
+            return 2;
+        case 2:
+            // 1x speed
+            return 1;
+        case 3:
+            // 0.5x speed
+            return 2;
+        case 4:
+            // 0.25x speed
+            return 4;
+        default: // Input = 0
+            // 2x speed
+            return 1;
+    }
+}
+
+static uint16_t speedInc(uint16_t pot_raw) {
+    uint8_t pot = round(4 * (float)pot_raw / (1 << 12));
+
+    switch(pot) {
+        case 1:
+            // 1.5x speed
+            return 3;
+        case 2:
+            // 1x speed
+            return 1;
+        case 3:
+            // 0.5x speed
+            return 1;
+        case 4:
+            // 0.25x speed
+            return 1;
+        default: // Input = 0
+            // 2x speed
+            return 2;
+    }
+}
+
+// Map potentiometer input to block size for checkerboard demo
+static uint16_t setBlockSize(uint16_t pot_raw) {
+    uint8_t pot = round(5 * (float)pot_raw / (1 << 12));
+
+    switch(pot) {
+        case 1:
+            return 64;
+        case 2:
+            return 32;
+        case 3:
+            return 16;
+        case 4:
+            return 8;
+        case 5:
+            return 4;
+        default: // Input = 0
+            return 128;
+    }
+}
+
+// Read one ADC input
+static uint16_t read_pot(uint input) {
+    adc_select_input(input);
+    return adc_read();
+}
+
+// Stage a pot-derived value if it differs from what the pot last gave
+static uint pot_update(param_update_t *updates, uint count, uint8_t id, uint16_t value) {
+    if(pot_value[id] != value) {
+        pot_value[id] = value;
+        updates[count].id = id;
+        updates[count].value = value;
+        count++;
+    }
+    return count;
+}
+
+// Stage the parameters derived from pot_readings, or with stage false only
+// note them, so the pots take over once moved (a follower on a video wall
+// only notes them, see wall.h)
+static void map_pots(bool stage) {
+    param_update_t updates[PARAM_COUNT];
+    uint count = 0;
+
+    // Pot 0 (GPIO26) controls speed, block size, pattern color, plasma scale and
+    // noise density (every cell lit, thinning to a sixteenth as it turns up)
+    uint16_t pot0 = pot_readings[0];
+    count = pot_update(updates, count, PARAM_SPEED_INC, speedInc(pot0));
+    count = pot_update(updates, count, PARAM_SPEED_FRAME, speedFrame(pot0));
+    count = pot_update(updates, count, PARAM_BLOCK_SIZE, setBlockSize(pot0));
+    count = pot_update(updates, count, PARAM_PATTERN_MASK, round(0x1f * (float)pot0 / (1 << 12)));
+    count = pot_update(updates, count, PARAM_PLASMA_SCALE, 1 + round(7 * (float)pot0 / (1 << 12)));
+    count = pot_update(updates, count, PARAM_NOISE_DENSITY, 256 - round(240 * (float)pot0 / (1 << 12)));
+
+    // Pot 1 (GPIO27) selects the demo
+    uint16_t pot1 = pot_readings[1];
+    count = pot_update(updates, count, PARAM_DEMO, round((DEMO_COUNT - 1) * (float)pot1 / (1 << 12)));
+
+    if(count && stage && !wall_following()) {
+        params_stage(updates, count);
+    }
+}
+
+static void poll_pots(void) {
+    pot_readings[0] = read_pot(0);
+    pot_readings[1] = read_pot(1);
+    map_pots(true);
+}
+
+// Force every pot-driven parameter to be staged on the next mapping
+static void reset_pot_values(void) {
+    for(uint id = 0; id < PARAM_COUNT; id++) {
+        pot_value[id] = 0xffff;
+    }
+}
+
+static void put_usb(uint8_t c) {
+    putchar_raw(c);
+}
+
+static void trace_stop(void) {
+    if(trace_mode == TRACE_RECORD) {
+        trace_write(&trace, put_usb);
+        stdio_flush();
+    }
+    trace_mode = TRACE_OFF;
+}
+
+// Follow PARAM_TRACE and step the trace once per rendered frame
+static void poll_trace(void) {
+    if(param(PARAM_TRACE) != trace_param) {
+        trace_param = param(PARAM_TRACE);
+        trace_stop();
+        if(trace_param == TRACE_RECORD) {
+            trace_clear(&trace);
+            trace_mode = TRACE_RECORD;
+        } else if(trace_param == TRACE_REPLAY && trace.count) {
+            // Start from the traced pot state rather than whatever USB last set
+            trace_rewind(&trace);
+            reset_pot_values();
+            trace_mode = TRACE_REPLAY;
+        }
+    }
+
+    if(trace_mode == TRACE_OFF || render_stats.frame == trace_frame) {
+        return;
+    }
+    trace_frame = render_stats.frame;
+
+    if(trace_mode == TRACE_RECORD) {
+        // Stop and send the trace when full
+        if(!trace_record(&trace, pot_readings)) {
+            trace_stop();
+        }
+    } else {
+        trace_replay(&trace, pot_readings);
+        map_pots(true);
+    }
+}
+
+static void poll_usb(void) {
+    int c;
+    while((c = getchar_timeout_us(0)) != PICO_ERROR_TIMEOUT) {
+        if(param_decoder_feed(&usb_decoder, (uint8_t)c)) {
+            params_stage(usb_decoder.updates, usb_decoder.count);
+        }
+    }
+}
+
+void control_init(void) {
+    // USB CDC for parameter protocol
+    stdio_init_all();
+    param_decoder_init(&usb_decoder);
+
+    // Initialize ADC for potentiometers
+    adc_init();
+    adc_gpio_init(26); // ADC input 0
+    adc_gpio_init(27); // ADC input 1
+
+    // Force every pot-driven parameter to be staged on the first poll, unless a
+    // saved scene was restored, which the pots only override once moved
+    reset_pot_values();
+    if(persist_scene_restored()) {
+        pot_readings[0] = read_pot(0);
+        pot_readings[1] = read_pot(1);
+        map_pots(false);
+    } else {
+        poll_pots();
+    }
+    last_pot_poll = time_us_32();
+
+    trace_clear(&trace);
+    trace_mode = TRACE_OFF;
+    trace_param = TRACE_OFF;
+    trace_frame = render_stats.frame;
+}
+
+bool control_load_trace(const uint8_t *data, size_t len) {
+    trace_stop();
+    trace_param = TRACE_OFF;
+    return trace_read(&trace, data, len);
+}
+
+void control_poll(void) {
+    poll_usb();
+
+    // The pots are not read while a trace is replaying
+    uint32_t now = time_us_32();
+    if(now - last_pot_poll >= POT_POLL_US && trace_mode != TRACE_REPLAY) {
+        last_pot_poll = now;
+        poll_pots();
+    }
+
+    poll_trace();
+}
+
+uint16_t control_pot(uint n) {
+    return pot_readings[n];
+}
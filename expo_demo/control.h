@@ -0,0 +1,23 @@
+// Core 0 control inputs (potentiometers and USB parameter protocol)
+
+#ifndef CONTROL_H
+#define CONTROL_H
+
+#include "pico.h"
+#include <stddef.h>
+
+// Set up ADC and USB CDC, must be called before control_poll
+void control_init(void);
+
+// Service pots and USB, call continuously from the core 0 main loop
+// Also records or replays the pot trace selected by PARAM_TRACE (see trace.h)
+void control_poll(void);
+
+// Latest raw reading (0-4095) of pot n, live or replayed
+uint16_t control_pot(uint n);
+
+// Replace the pot trace with a serialized one, replayed when PARAM_TRACE
+// next becomes TRACE_REPLAY. Returns false if the data is malformed
+bool control_load_trace(const uint8_t *data, size_t len);
+
+#endif
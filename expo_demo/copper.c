@@ -0,0 +1,155 @@
+#include "copper.h"
+#include "span.h"
+#include "params.h"
+#include "palette.h"
+#include "regions.h"
+#include "video_mode.h"
+#include "persist.h"
+#include "wall.h"
+#include "trig.h"
+#include "handoff.h"
+#include "placement.h"
+
+// Lines covered by the lists (taller modes leave the bottom black)
+#define COPPER_MAX_LINES 480
+
+#define BARS 7
+// Shades from the middle of a bar to its edge
+#define BAR_SHADES 16
+// Steps of the sky gradient from the top of the canvas to the bottom
+#define SKY_STEPS 64
+
+typedef struct {
+    copper_line_t lines[COPPER_MAX_LINES];
+} copper_list_t;
+
+// Colors worked out at start-up
+typedef struct {
+    uint16_t sky[SKY_STEPS];
+    // Bar shades left and right of the split
+    uint16_t bars[2][BARS][BAR_SHADES];
+} copper_colors_t;
+
+static copper_colors_t colors;
+
+// List being shown and the one core 0 is building
+static copper_list_t lists[2];
+static handoff_t handoff = HANDOFF_INIT;
+
+static uint16_t lines;
+static const copper_line_t blank_line;
+
+// Core 0 state: swing of the bars and of the split, 8.8 steps of trig_sin
+static uint16_t bar_angle, split_angle;
+
+static void build_colors(void) {
+    // Deep blue overhead to dusky purple at the horizon
+    for(uint n = 0; n < SKY_STEPS; n++) {
+        float t = (float)n / (SKY_STEPS - 1);
+        colors.sky[n] = palette_hsv(0.66f + 0.16f * t, 0.9f, 0.08f + 0.3f * t);
+    }
+    // Bars spread round the hue wheel, and opposite it right of the split
+    for(uint side = 0; side < 2; side++) {
+        for(uint b = 0; b < BARS; b++) {
+            float hue = (float)b / BARS + 0.5f * side;
+            for(uint s = 0; s < BAR_SHADES; s++) {
+                float edge = (float)s / BAR_SHADES;
+                colors.bars[side][b][s] = palette_hsv(hue, 0.4f + 0.6f * edge, 1 - 0.85f * edge * edge);
+            }
+        }
+    }
+}
+
+// Test pattern color mask: the 3-bit color number steps from 1 to 7 down the canvas
+static uint16_t pattern_mask(uint32_t y) {
+    uint32_t primary_color = 1u + (y * 7 / wall_height);
+    return PICO_SCANVIDEO_PIXEL_FROM_RGB5(0x1f * (primary_color & 1u), 0x1f * ((primary_color >> 1u) & 1u),
+                                          0x1f * ((primary_color >> 2u) & 1u));
+}
+
+// Swing the bars and the split steps frames on
+static void advance(uint steps) {
+    uint16_t speed = steps * param(PARAM_SPEED_INC);
+    bar_angle += speed * 96;
+    split_angle += speed * 160;
+}
+
+static void build(copper_list_t *list) {
+    // Sky behind everything, and the split swinging in two waves down the canvas
+    int32_t split_swing = wall_width / 6;
+    for(uint n = 0; n < lines; n++) {
+        uint32_t y = wall_y0 + n;
+        copper_line_t *line = &list->lines[n];
+        line->left = line->right = colors.sky[y * SKY_STEPS / wall_height];
+        uint8_t angle = (y * 512 / wall_height) + (split_angle >> 8);
+        line->split = wall_width / 2 + (split_swing * trig_sin[angle] >> 14);
+    }
+
+    // Bars on the far side of their turn first, so the near ones cover them
+    int32_t half = MAX(wall_height / 24, 2);
+    int32_t swing = wall_height / 2 - half;
+    for(uint near = 0; near < 2; near++) {
+        for(uint b = 0; b < BARS; b++) {
+            uint8_t angle = (bar_angle >> 8) + b * 256 / BARS / 2;
+            if((trig_cos(angle) >= 0) != near) {
+                continue;
+            }
+            int32_t middle = wall_height / 2 + (swing * trig_sin[angle] >> 14) - wall_y0;
+            for(int32_t d = -half; d <= half; d++) {
+                int32_t n = middle + d;
+                if(n < 0 || n >= lines) {
+                    continue;
+                }
+                uint shade = ((d < 0) ? -d : d) * BAR_SHADES / (half + 1);
+                list->lines[n].left = colors.bars[0][b][shade];
+                list->lines[n].right = colors.bars[1][b][shade];
+            }
+        }
+    }
+}
+
+void copper_init(void) {
+    if(!persist_table(PERSIST_TABLE_COPPER_COLORS, &colors, sizeof(colors))) {
+        build_colors();
+    }
+    lines = MIN(vga_mode.height, COPPER_MAX_LINES);
+
+    // The pattern masks never change, so they are written once into both lists
+    for(uint n = 0; n < lines; n++) {
+        lists[0].lines[n].pattern_mask = pattern_mask(wall_y0 + n);
+    }
+    bar_angle = 0;
+    split_angle = 0;
+    advance(1);
+    build(&lists[0]);
+    lists[1] = lists[0];
+    handoff_init(&handoff);
+}
+
+void copper_poll(void) {
+    // Wait for core 1 to pick up the last list, and only step while the demo
+    // is on screen
+    uint steps;
+    if(!regions_show_demo(DEMO_COPPER) || !(steps = handoff_begin_step(&handoff))) {
+        return;
+    }
+    advance(steps);
+    build(&lists[handoff_back(&handoff)]);
+    handoff_publish(&handoff);
+}
+
+void copper_begin_frame(void) {
+    handoff_take(&handoff);
+}
+
+const copper_line_t *__render_func(copper_line)(uint16_t y) {
+    uint16_t n = y - wall_y0;
+    return (n < lines) ? &lists[handoff.front].lines[n] : &blank_line;
+}
+
+uint16_t *__render_func(copper_span)(uint16_t *p, uint16_t y, uint16_t x0, uint16_t x1) {
+    const copper_line_t *line = copper_line(y);
+    uint16_t split = MIN(MAX(line->split, x0), x1);
+    p = span_color(p, line->left, split - x0);
+    return span_color(p, line->right, x1 - split);
+}
@@ -0,0 +1,43 @@
+// Copper lists: per-line color programs
+//
+// Named after the Amiga coprocessor that rewrote color registers as the beam
+// moved down the screen. Each frame core 0 builds a list with one entry per
+// line holding everything that changes from line to line, and core 1 picks up
+// the newest list at the frame boundary. An effect reads its line's entry with
+// one indexed load instead of working the colors out per line, so raster
+// bars, gradients and split colors cost a color run or two per line however
+// much work went into the list.
+//
+// The copper demo draws the list as it is: shaded raster bars swinging
+// through a sky gradient, with the bars in complementary colors right of a
+// wavy split. The test pattern takes its per-line color mask from the list.
+
+#ifndef COPPER_H
+#define COPPER_H
+
+#include "pico.h"
+
+// One line of the list
+typedef struct {
+    uint16_t left, right;  // Colors either side of the split
+    uint16_t split;        // Canvas x where the right color starts
+    uint16_t pattern_mask; // Color mask of the test pattern demo
+} copper_line_t;
+
+// Build the color tables and the first list (call once before drawing)
+void copper_init(void);
+
+// Build the next list if the copper demo is on screen and core 1 has picked
+// up the last one (core 0, call often)
+void copper_poll(void);
+
+// Switch to the newest list (core 1, at frame boundary)
+void copper_begin_frame(void);
+
+// Entry for canvas line y
+const copper_line_t *copper_line(uint16_t y);
+
+// Write pixels x0 to x1 (exclusive) of line y of the copper demo
+uint16_t *copper_span(uint16_t *p, uint16_t y, uint16_t x0, uint16_t x1);
+
+#endif
@@ -0,0 +1,286 @@
+#include "effects.h"
+#include "span.h"
+#include "video_mode.h"
+#include "params.h"
+#include "plasma.h"
+#include "polar.h"
+#include "life.h"
+#include "particles.h"
+#include "solid.h"
+#include "scroll.h"
+#include "wobble.h"
+#include "copper.h"
+#include "noise.h"
+#include "palette.h"
+#include "governor.h"
+#include "wall.h"
+#include "placement.h"
+#include <math.h>
+
+uint16_t effect_offset = 0;
+
+// Width of one block in the blocky demos (one COMPOSABLE_COLOR_RUN of length 4)
+#define BLOCK_WIDTH 4
+
+// Lines per cycle of the sinusoidal demo's color levels
+#define SINE_PERIOD 90
+
+// 5-bit color level |cos(2 degrees * n)| of the sinusoidal demo for each line of
+// a cycle (built once, so the demo has no trig while drawing)
+static uint8_t __render_table sine_levels[SINE_PERIOD];
+
+// Color of one bar of the test pattern
+static inline uint16_t bar_color(uint bar, uint16_t pot, uint32_t color_mask) {
+    return PICO_SCANVIDEO_PIXEL_FROM_RGB5(bar & pot, bar & pot, bar & pot) & color_mask;
+}
+
+// Pixel data for test pattern demo
+// Modified version of https://github.com/raspberrypi/pico-playground/blob/master/scanvideo/test_pattern/test_pattern.c
+static uint16_t *__render_func(draw_pattern)(uint16_t *p, uint16_t y, uint16_t x0, uint16_t x1) {
+    // Primary color for the line from the copper list
+    uint32_t color_mask = copper_line(y)->pattern_mask;
+
+    uint16_t pot = param(PARAM_PATTERN_MASK);
+
+    uint bar_width = wall_width / 32;
+
+    // Masking with pot repeats each color for the bars up to its lowest set
+    // bit, so bars come in groups of one color, and neighbouring groups
+    // alternate two colors until a higher bit of pot changes
+    uint group = (pot & -pot) ? (pot & -pot) : 32;
+    uint group_width = group * bar_width;
+    uint bars_end = 32 * bar_width;
+
+    uint x = x0;
+    while(x < MIN(x1, bars_end)) {
+        uint g = x / group_width;
+        uint16_t a = bar_color(g * group, pot, color_mask);
+        uint16_t b = bar_color((g + 1) * group, pot, color_mask);
+
+        // Groups until the colors stop alternating a, b, a...
+        uint end = g + 1;
+        while(end < 32 / group) {
+            if(bar_color(end * group, pot, color_mask) != ((end - g) & 1 ? b : a)) {
+                break;
+            }
+            end++;
+        }
+        uint run_end = MIN(end * group_width, x1);
+        p = span_stripes(p, a, b, group_width, x - g * group_width, run_end - x);
+        x = run_end;
+    }
+
+    // Black past the last bar when width is not a multiple of 32
+    return span_color(p, 0, x1 - x);
+}
+
+// Pixel data for box demo
+static uint16_t *__render_func(draw_box)(uint16_t *p, uint16_t y, uint16_t x0, uint16_t x1) {
+
+    uint16_t w_blocks = wall_width / BLOCK_WIDTH;
+    uint16_t height = wall_height;
+
+    uint16_t background = PICO_SCANVIDEO_PIXEL_FROM_RGB5(0x1f, 0, 0x1f);
+
+    if(!(y >= height/3 && y <= 2*height/3)) {
+        return span_color(p, background, x1 - x0);
+    }
+
+    // Box covers blocks offset..offset + w_blocks/3 and wraps after moving 2/3 of the way across
+    uint16_t offset = effect_offset % (2*w_blocks/3 + 1);
+    uint16_t box_x0 = MIN(MAX(offset * BLOCK_WIDTH, x0), x1);
+    uint16_t box_x1 = MIN(MAX((offset + w_blocks/3 + 1) * BLOCK_WIDTH, box_x0), x1);
+
+    p = span_color(p, background, box_x0 - x0);
+    p = span_color(p, PICO_SCANVIDEO_PIXEL_FROM_RGB5(0x1f, 0x1f, 0), box_x1 - box_x0);
+    return span_color(p, background, x1 - box_x1);
+}
+
+// Pixel data for checkerboard demo
+static uint16_t *__render_func(draw_checkerboard)(uint16_t *p, uint16_t y, uint16_t x0, uint16_t x1) {
+
+    uint16_t block_size = param(PARAM_BLOCK_SIZE);
+
+    // Black squares are block_size/4 blocks wide and repeat every block_size/2 blocks,
+    // with rows swapping every block_size lines
+    uint16_t square_width = (block_size / 4) * BLOCK_WIDTH;
+    uint16_t period = (block_size / 2) * BLOCK_WIDTH;
+    bool first_black = y % (2*block_size) < block_size;
+
+    uint16_t black = PICO_SCANVIDEO_PIXEL_FROM_RGB5(0, 0, 0);
+    uint16_t white = PICO_SCANVIDEO_PIXEL_FROM_RGB5(0x1f, 0x1f, 0x1f);
+
+    uint16_t phase = x0 % period;
+    if(period == 2 * square_width) {
+        // Squares as wide as the gaps between them are plain stripes
+        return span_stripes(p, first_black ? black : white, first_black ? white : black,
+                            square_width, phase, x1 - x0);
+    }
+
+    uint16_t x = x0;
+    while(x < x1) {
+        // Emit up to the next square edge
+        bool in_first = phase < square_width;
+        uint16_t edge = in_first ? square_width : period;
+        uint16_t len = MIN(edge - phase, x1 - x);
+        p = span_color(p, (in_first == first_black) ? black : white, len);
+        x += len;
+        phase += len;
+        if(phase == period) {
+            phase = 0;
+        }
+    }
+    return p;
+}
+
+// Pixel data for sinusoidal demo (color only depends on the line)
+static uint16_t *__render_func(draw_sine)(uint16_t *p, uint16_t y, uint16_t x0, uint16_t x1) {
+    uint8_t r = sine_levels[(y + effect_offset) % SINE_PERIOD];
+    uint8_t g = sine_levels[((int32_t)y - effect_offset % SINE_PERIOD + SINE_PERIOD) % SINE_PERIOD];
+    return span_color(p, PICO_SCANVIDEO_PIXEL_FROM_RGB5(r, g, 0x1f), x1 - x0);
+}
+
+static uint16_t *__render_func(draw_plasma)(uint16_t *p, uint16_t y, uint16_t x0, uint16_t x1) {
+    return plasma_span(p, PLASMA_CLASSIC, y, x0, x1, effect_offset, param(PARAM_PLASMA_SCALE), governor_half_width());
+}
+
+static uint16_t *__render_func(draw_interference)(uint16_t *p, uint16_t y, uint16_t x0, uint16_t x1) {
+    return plasma_span(p, PLASMA_INTERFERENCE, y, x0, x1, effect_offset, param(PARAM_PLASMA_SCALE), governor_half_width());
+}
+
+static uint16_t *__render_func(draw_moire)(uint16_t *p, uint16_t y, uint16_t x0, uint16_t x1) {
+    return plasma_span(p, PLASMA_MOIRE, y, x0, x1, effect_offset, param(PARAM_PLASMA_SCALE), governor_half_width());
+}
+
+static uint16_t *__render_func(draw_tunnel)(uint16_t *p, uint16_t y, uint16_t x0, uint16_t x1) {
+    return polar_span(p, POLAR_TUNNEL, y, x0, x1, effect_offset, param(PARAM_PLASMA_SCALE), governor_half_width());
+}
+
+static uint16_t *__render_func(draw_rings)(uint16_t *p, uint16_t y, uint16_t x0, uint16_t x1) {
+    return polar_span(p, POLAR_RINGS, y, x0, x1, effect_offset, param(PARAM_PLASMA_SCALE), governor_half_width());
+}
+
+static uint16_t *__render_func(draw_spiral)(uint16_t *p, uint16_t y, uint16_t x0, uint16_t x1) {
+    return polar_span(p, POLAR_SPIRAL, y, x0, x1, effect_offset, param(PARAM_PLASMA_SCALE), governor_half_width());
+}
+
+static uint16_t *__render_func(draw_life)(uint16_t *p, uint16_t y, uint16_t x0, uint16_t x1) {
+    // Live cells shaded by row, so color cycling sweeps up the screen
+    return life_span(p, y, x0, x1, palette[(uint8_t)(y + effect_offset)]);
+}
+
+static uint16_t *__render_func(draw_starfield)(uint16_t *p, uint16_t y, uint16_t x0, uint16_t x1) {
+    return particles_span(PARTICLES_STARFIELD, p, y, x0, x1);
+}
+
+static uint16_t *__render_func(draw_sparks)(uint16_t *p, uint16_t y, uint16_t x0, uint16_t x1) {
+    return particles_span(PARTICLES_SPARKS, p, y, x0, x1);
+}
+
+static uint16_t *__render_func(draw_cube)(uint16_t *p, uint16_t y, uint16_t x0, uint16_t x1) {
+    return solid_span(SOLID_CUBE, p, y, x0, x1);
+}
+
+static uint16_t *__render_func(draw_torus)(uint16_t *p, uint16_t y, uint16_t x0, uint16_t x1) {
+    return solid_span(SOLID_TORUS, p, y, x0, x1);
+}
+
+static uint16_t *__render_func(draw_scroll)(uint16_t *p, uint16_t y, uint16_t x0, uint16_t x1) {
+    return scroll_span(p, y, x0, x1);
+}
+
+static uint16_t *__render_func(draw_copper)(uint16_t *p, uint16_t y, uint16_t x0, uint16_t x1) {
+    return copper_span(p, y, x0, x1);
+}
+
+static uint16_t *__render_func(draw_noise)(uint16_t *p, uint16_t y, uint16_t x0, uint16_t x1) {
+    return noise_span(p, y, x0, x1);
+}
+
+// Token costs: a run of one color takes up to 3 halfwords, raw pixels 1 each
+// plus 2 for the run, and a particle with the gap before it up to 5 (a face's
+// piece and gap 6). Blocks, squares and bars are at least 4 pixels wide
+const effect_t effects[DEMO_COUNT] = {
+    [DEMO_SINE]         = {"sine", draw_sine, 3, 3},
+    [DEMO_CHECKERBOARD] = {"checkerboard", draw_checkerboard, 3, 0},
+    [DEMO_BOX]          = {"box", draw_box, 3, 9},
+    [DEMO_PATTERN]      = {"pattern", draw_pattern, 3, 0},
+    [DEMO_PLASMA]       = {"plasma", draw_plasma, 4, 0},
+    [DEMO_INTERFERENCE] = {"interference", draw_interference, 4, 0},
+    [DEMO_MOIRE]        = {"moire", draw_moire, 4, 0},
+    [DEMO_TUNNEL]       = {"tunnel", draw_tunnel, 4, 0},
+    [DEMO_RINGS]        = {"rings", draw_rings, 4, 0},
+    [DEMO_SPIRAL]       = {"spiral", draw_spiral, 4, 0},
+    [DEMO_LIFE]         = {"life", draw_life, 4, 0},
+    [DEMO_STARFIELD]    = {"starfield", draw_starfield, 8, PARTICLE_LINE_MAX * 5 + 3},
+    [DEMO_SPARKS]       = {"sparks", draw_sparks, 8, PARTICLE_LINE_MAX * 5 + 3},
+    [DEMO_CUBE]         = {"cube", draw_cube, 8, SOLID_LINE_PIECES * 6 + 3},
+    [DEMO_TORUS]        = {"torus", draw_torus, 8, SOLID_LINE_PIECES * 6 + 3},
+    [DEMO_SCROLL]       = {"scroll", draw_scroll, 2, 0},
+    [DEMO_COPPER]       = {"copper", draw_copper, 3, 6},
+    [DEMO_NOISE]        = {"noise", draw_noise, 4, 0},
+};
+
+void effects_begin_frame(void) {
+    // Frames since the offset last moved
+    static uint8_t frame_count = 0;
+    frame_count++;
+
+    // Values to control speed of animated demos
+    // Speed factor = i_inc/i_frame
+    uint8_t i_inc = param(PARAM_SPEED_INC); // Amount by which offset increases
+    uint8_t i_frame = param(PARAM_SPEED_FRAME); // Number of frames until offset updates
+
+    if(frame_count % i_frame == 0) {
+        effect_offset += i_inc;
+        frame_count = 0;
+    }
+
+    // Keep offset value low so that sinusoidal demo does not struggle to keep up
+    if(effect_offset >= 10000) {
+        effect_offset = 0;
+    }
+}
+
+void effects_init(void) {
+    // Color levels of the sinusoidal demo
+    for(uint n = 0; n < SINE_PERIOD; n++) {
+        sine_levels[n] = round(0x1f * fabs(cos(2 * (double)n * M_PI / 180)));
+    }
+
+    // Build gradients and the lookup tables used by the plasma and polar demos,
+    // seed the cellular automaton and starfield, build the solids' meshes and
+    // encode the first lines of the scrolling background
+    palette_init();
+    plasma_init();
+    polar_init();
+    life_init();
+    particles_init();
+    solid_init();
+    scroll_init();
+    wobble_init();
+    copper_init();
+}
+
+void effects_poll(void) {
+    life_poll();
+    particles_poll();
+    solid_poll();
+    scroll_poll();
+    copper_poll();
+}
+
+uint16_t effect_line_halfwords(uint8_t demo, uint16_t width) {
+    const effect_t *e = &effects[demo];
+    uint32_t halfwords = (uint32_t)(width + 3) / 4 * e->quad_halfwords;
+    return e->max_halfwords ? MIN(halfwords, e->max_halfwords) : halfwords;
+}
+
+void draw_effect(scanvideo_scanline_buffer_t *buffer, uint8_t demo) {
+    uint16_t y = scanvideo_scanline_number(buffer->scanline_id);
+    uint16_t *p = (uint16_t *) buffer->data;
+
+    p = effects[demo].span(p, y, 0, vga_mode.width);
+
+    span_end_line(buffer, p);
+}
@@ -0,0 +1,47 @@
+// Demo effects
+//
+// Every effect draws a horizontal span of a line, so effects can share a
+// line (see regions.h). Coordinates are screen pixels.
+
+#ifndef EFFECTS_H
+#define EFFECTS_H
+
+#include "pico.h"
+#include "pico/scanvideo.h"
+
+// Write pixels x0 to x1 (exclusive) of line y, returns the advanced data pointer
+typedef uint16_t *(*effect_span_t)(uint16_t *p, uint16_t y, uint16_t x0, uint16_t x1);
+
+typedef struct {
+    const char *name;
+    effect_span_t span;
+    // Most halfwords of tokens a line of the effect takes: per 4 pixels, and
+    // in all however wide the line (0 if only the first bounds it)
+    uint8_t quad_halfwords;
+    uint16_t max_halfwords;
+} effect_t;
+
+// Indexed by DEMO_* (see params.h)
+extern const effect_t effects[];
+
+// Offset value for animated demos (advanced once per frame by core 1)
+extern uint16_t effect_offset;
+
+// Build lookup tables (call once before drawing)
+void effects_init(void);
+
+// Advance animation by one frame (core 1, at frame boundary after params_apply_pending)
+void effects_begin_frame(void);
+
+// Step the effects whose state core 0 works out (cellular automaton,
+// particles, solids, scrolling background) if they are on screen (core 0,
+// call often)
+void effects_poll(void);
+
+// Most halfwords of tokens the effect of a demo takes for a line width pixels wide
+uint16_t effect_line_halfwords(uint8_t demo, uint16_t width);
+
+// Draw a whole line of one effect
+void draw_effect(scanvideo_scanline_buffer_t *buffer, uint8_t demo);
+
+#endif
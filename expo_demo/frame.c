@@ -0,0 +1,82 @@
+#include "frame.h"
+#include "params.h"
+#include "effects.h"
+#include "regions.h"
+#include "osd.h"
+#include "palette.h"
+#include "governor.h"
+#include "life.h"
+#include "particles.h"
+#include "solid.h"
+#include "scroll.h"
+#include "modulation.h"
+#include "wobble.h"
+#include "copper.h"
+#include "noise.h"
+#include "wall.h"
+#include "placement.h"
+#include <string.h>
+
+void frame_begin(bool first) {
+    // Animation steps for this frame (more or fewer than one when following
+    // another board's frames on a video wall)
+    uint steps = wall_begin_frame(first);
+
+    // Pick up parameter changes from core 0 (pots/USB) and the wall's leader for
+    // the whole frame, pass them on to the rest of the wall, and add the
+    // modulation core 0 worked out for the frame
+    uint32_t changed = params_apply_pending();
+    wall_send_frame(changed, first);
+    modulation_begin_frame();
+
+    // Drop or restore resolution based on how the last frame went
+    governor_begin_frame();
+
+    // Advance animation and color cycling, lay out regions and pick up the OSD panel
+    // and the core 0 effect state (cellular automaton, particles, solids, copper list) for the new frame,
+    // scroll the background, move the raster wobble on and reseed the noise
+    for(uint n = 0; n < steps; n++) {
+        effects_begin_frame();
+    }
+    palette_begin_frame(steps);
+    regions_begin_frame();
+    osd_begin_frame();
+    life_begin_frame();
+    particles_begin_frame();
+    solid_begin_frame();
+    copper_begin_frame();
+    scroll_begin_frame(steps);
+    wobble_begin_frame(steps);
+    noise_begin_frame();
+}
+
+// Copy the tokens of the line above if previous holds it and the OSD doesn't
+// cover either line (its rows all differ)
+static bool __render_func(repeat_line)(scanvideo_scanline_buffer_t *buffer, const scanvideo_scanline_buffer_t *previous,
+                                       uint16_t y) {
+    uint16_t osd_x0, osd_x1;
+    if(!previous || previous == buffer || previous->scanline_id != buffer->scanline_id - 1 ||
+       osd_covers_line(y, &osd_x0, &osd_x1) || osd_covers_line(y - 1, &osd_x0, &osd_x1)) {
+        return false;
+    }
+    memcpy(buffer->data, previous->data, previous->data_used * sizeof(uint32_t));
+    buffer->data_used = previous->data_used;
+    buffer->status = SCANLINE_OK;
+    return true;
+}
+
+void __render_func(frame_draw_line)(scanvideo_scanline_buffer_t *buffer, const scanvideo_scanline_buffer_t *previous) {
+    uint16_t y = scanvideo_scanline_number(buffer->scanline_id);
+
+    // At the lowest governor level odd lines show the line above
+    uint16_t effect_y = y;
+    if(governor_repeat_lines() && (y & 1)) {
+        if(repeat_line(buffer, previous, y)) {
+            return;
+        }
+        effect_y = y - 1;
+    }
+
+    // Draw pixels to buffer (demo for each region set by potentiometer/USB input)
+    draw_regions(buffer, effect_y);
+}
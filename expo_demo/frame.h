@@ -0,0 +1,18 @@
+// Per-frame pipeline shared by core 1 and the host tools
+
+#ifndef FRAME_H
+#define FRAME_H
+
+#include "pico.h"
+#include "pico/scanvideo.h"
+
+// Update everything that changes once per frame (core 1, before the first line)
+// first is true for the very first frame, before any animation has run
+void frame_begin(bool first);
+
+// Draw one line of the current frame
+// previous is the buffer last drawn, if there is one and it is still intact;
+// it may be copied from when the governor repeats lines
+void frame_draw_line(scanvideo_scanline_buffer_t *buffer, const scanvideo_scanline_buffer_t *previous);
+
+#endif
@@ -0,0 +1,79 @@
+#include "governor.h"
+#include "params.h"
+#include "telemetry.h"
+#include "regions.h"
+#include "effects.h"
+#include "video_mode.h"
+
+// Step down when headroom falls below this (or any line was late)
+#define HEADROOM_LOW_PCT 10
+// Step up after this much headroom for RECOVER_FRAMES frames in a row
+// (high enough that the roughly doubled cost of the level above still fits)
+#define HEADROOM_HIGH_PCT 60
+#define RECOVER_FRAMES 60
+
+volatile uint8_t governor_level = RESOLUTION_FULL;
+
+uint8_t governor_demo_levels[DEMO_COUNT];
+
+bool governor_demo_fit[DEMO_COUNT];
+
+// Richest level the demos on screen were calibrated for when last checked
+// (0xff to pick it up again)
+static uint8_t last_ceiling = 0xff;
+
+// Frames in a row with enough headroom to step up
+static uint8_t calm_frames;
+// Stats frame the last decision was based on
+static uint32_t last_stats_frame;
+
+void governor_init(void) {
+    uint32_t room = 2 * PICO_SCANVIDEO_MAX_SCANLINE_BUFFER_WORDS - GOVERNOR_LINE_MARGIN_HALFWORDS;
+    for(uint demo = 0; demo < DEMO_COUNT; demo++) {
+        governor_demo_fit[demo] = effect_line_halfwords(demo, vga_mode.width) <= room;
+    }
+}
+
+void governor_begin_frame(void) {
+    uint8_t mode = param(PARAM_RESOLUTION);
+    if(mode != RESOLUTION_AUTO) {
+        governor_level = mode;
+        calm_frames = 0;
+        last_ceiling = 0xff;
+        return;
+    }
+
+    // Jump straight to the calibrated level when the demos on screen change
+    // (demos left blank don't count)
+    uint8_t ceiling = RESOLUTION_FULL;
+    for(uint demo = 0; demo < DEMO_COUNT; demo++) {
+        if(regions_show_demo(demo) && governor_demo_fit[demo]) {
+            ceiling = MAX(ceiling, governor_demo_levels[demo]);
+        }
+    }
+    if(ceiling != last_ceiling) {
+        last_ceiling = ceiling;
+        governor_level = ceiling;
+        calm_frames = 0;
+    }
+
+    // Only judge frames that have been measured
+    if(render_stats.frame == last_stats_frame) {
+        return;
+    }
+    last_stats_frame = render_stats.frame;
+
+    if(render_stats.late_lines || render_stats.headroom_pct < HEADROOM_LOW_PCT) {
+        if(governor_level < RESOLUTION_HALF_BOTH) {
+            governor_level++;
+        }
+        calm_frames = 0;
+    } else if(render_stats.headroom_pct >= HEADROOM_HIGH_PCT && governor_level > ceiling) {
+        if(++calm_frames >= RECOVER_FRAMES) {
+            governor_level--;
+            calm_frames = 0;
+        }
+    } else {
+        calm_frames = 0;
+    }
+}
@@ -0,0 +1,72 @@
+// Resolution governor
+//
+// Watches the render headroom published by telemetry each frame. When lines
+// come close to (or go over) their budget, it steps down to a cheaper level
+// instead of letting scanvideo drop lines; once there has been plenty of
+// headroom for a while it steps back up.
+//
+// Levels, cheapest last:
+//   full       Every pixel and line rendered
+//   half width Per-pixel effects compute one pixel in two and double it
+//   half both  Half width, and odd lines repeat the line above (copied from
+//              the previous scanline buffer where possible)
+//
+// If calibration (see calibrate.h) has measured the demos, automatic mode
+// starts at the richest level every demo on screen can sustain and does not
+// step up past it.
+//
+// A demo whose lines don't fit the scanline buffer at this video mode's width
+// (from its tokens per pixel) is left blank at every level, since the cheaper
+// levels compute fewer pixels but write the same tokens. That only happens
+// when the buffer is set smaller than the mode needs, see CMakeLists.txt.
+
+#ifndef GOVERNOR_H
+#define GOVERNOR_H
+
+#include "pico.h"
+#include "params.h"
+
+// Values of PARAM_RESOLUTION
+enum {
+    RESOLUTION_AUTO, // Governor picks the level
+    RESOLUTION_FULL, // Fixed levels
+    RESOLUTION_HALF_WIDTH,
+    RESOLUTION_HALF_BOTH,
+    RESOLUTION_COUNT
+};
+
+// Halfwords of a line's scanline buffer kept for the closing black pixel and
+// end of line, and for the extra run tokens where regions, the OSD and
+// symmetry cut a demo's spans. A demo fits if its lines take no more than
+// the rest
+#define GOVERNOR_LINE_MARGIN_HALFWORDS 32
+
+// Current level (RESOLUTION_FULL to RESOLUTION_HALF_BOTH)
+extern volatile uint8_t governor_level;
+
+// Richest level each demo can sustain on its own, from calibration
+// (0 if not measured, written before core 1 starts)
+extern uint8_t governor_demo_levels[DEMO_COUNT];
+
+// Whether each demo's lines fit the scanline buffer, so it can be drawn at all
+// (written by governor_init before core 1 starts)
+extern bool governor_demo_fit[DEMO_COUNT];
+
+// Work out which demos fit (core 0, before calibrate_init)
+void governor_init(void);
+
+// Pick the level for this frame from the last frame's stats
+// (core 1, at frame boundary after telemetry_end_frame and params_apply_pending)
+void governor_begin_frame(void);
+
+// Whether per-pixel effects should run at half horizontal resolution
+static inline bool governor_half_width(void) {
+    return governor_level >= RESOLUTION_HALF_WIDTH;
+}
+
+// Whether odd lines should repeat the line above
+static inline bool governor_repeat_lines(void) {
+    return governor_level >= RESOLUTION_HALF_BOTH;
+}
+
+#endif
@@ -0,0 +1,69 @@
+// Double-buffered handoff of state from core 0 to core 1
+//
+// Core 0 steps the next copy of some state (a grid, a bucket of particles, an
+// edge table) into the back buffer while core 1 draws from the front one, then
+// publishes it. Core 1 swaps it in at the next frame boundary. Core 0 doesn't
+// step again until core 1 has picked the last copy up, and then takes one step
+// for each wall frame since its last (several when a follower of a video wall
+// catches up with the leader), so a board's effect is as far on as the
+// leader's. Up to WALL_MAX_STEPS are taken at once and any more are dropped.
+// wall_frame moves on by at most that much a frame, so that only happens to an
+// effect that has been off screen (and not stepped), or whose steps take core 0
+// longer than a frame.
+
+#ifndef HANDOFF_H
+#define HANDOFF_H
+
+#include "pico.h"
+#include "pico/sync.h"
+#include "wall.h"
+
+typedef struct {
+    // Buffer core 1 draws from
+    volatile int8_t front;
+    // Buffer waiting to be picked up by core 1 (-1 if none)
+    volatile int8_t ready;
+    // Core 0 state: wall frame of the last step
+    uint32_t last_stepped_frame;
+} handoff_t;
+
+// Front buffer 0, nothing waiting and nothing stepped yet
+#define HANDOFF_INIT {0, -1, 0xffffffff}
+
+static inline void handoff_init(handoff_t *h) {
+    *h = (handoff_t)HANDOFF_INIT;
+}
+
+// How many steps core 0 should take now, noting them as taken: none until
+// core 1 has picked up the last step, then the wall frames since the last one
+static inline uint handoff_begin_step(handoff_t *h) {
+    if(h->ready >= 0) {
+        return 0;
+    }
+    uint32_t frame = wall_frame;
+    uint steps = MIN(frame - h->last_stepped_frame, WALL_MAX_STEPS);
+    h->last_stepped_frame = frame;
+    return steps;
+}
+
+// Buffer core 0 steps into
+static inline int8_t handoff_back(const handoff_t *h) {
+    return (h->front == 0) ? 1 : 0;
+}
+
+// Hand the back buffer to core 1 once it is written (core 0)
+static inline void handoff_publish(handoff_t *h) {
+    __mem_fence_release();
+    h->ready = handoff_back(h);
+}
+
+// Switch to the newest buffer if there is one (core 1, at frame boundary)
+static inline void handoff_take(handoff_t *h) {
+    if(h->ready >= 0) {
+        __mem_fence_acquire();
+        h->front = h->ready;
+        h->ready = -1;
+    }
+}
+
+#endif
@@ -0,0 +1,258 @@
+#include "life.h"
+#include "span.h"
+#include "params.h"
+#include "regions.h"
+#include "wall.h"
+#include "handoff.h"
+#include "rng.h"
+#include "placement.h"
+#include <string.h>
+
+#define GRID_MAX_WIDTH 320
+#define GRID_MAX_HEIGHT 240
+#define GRID_MAX_WORDS (GRID_MAX_WIDTH / 32)
+
+// Shortest run of cells drawn as a color run. Shorter runs are grouped into
+// raw spans at a halfword a pixel, and every color run saves at least the 2
+// halfwords a raw span costs on top of its pixels, so a line never takes more
+// than its width plus a few halfwords
+#define MIN_COLOR_RUN 5
+
+// Generations in a row that only repeat the one two back (still lifes and
+// blinkers) before the grid is reseeded
+#define STILL_LIMIT 120
+
+// One bit per cell, bit n of word k is cell 32 * k + n
+typedef uint32_t grid_t[GRID_MAX_HEIGHT][GRID_MAX_WORDS];
+
+// Generation being shown and the one core 0 is working on, and a scratch grid
+// for the generations in between when core 0 takes several steps at once
+#define SCRATCH_GRID 2
+static grid_t grids[3];
+static handoff_t handoff = HANDOFF_INIT;
+
+// Grid size in cells, and pixels per cell side
+static uint16_t grid_width, grid_height;
+static uint8_t grid_words;
+static uint8_t cell_size;
+// Valid cells in the last word of each row
+static uint32_t last_word_mask;
+
+static const uint32_t empty_row[GRID_MAX_WORDS];
+
+// Core 0 state
+static uint8_t rule;
+static uint16_t still_generations;
+static uint32_t rng = 0x2545f491;
+
+static void seed(grid_t *grid) {
+    memset(grid, 0, sizeof(grid_t));
+    if(rule == LIFE_RULE_GAME_OF_LIFE) {
+        // Random soup with about 3/8 of cells alive
+        for(uint y = 0; y < grid_height; y++) {
+            for(uint k = 0; k < grid_words; k++) {
+                uint32_t a = rng_next(&rng), b = rng_next(&rng), c = rng_next(&rng);
+                (*grid)[y][k] = a & (b | c);
+            }
+            (*grid)[y][grid_words - 1] &= last_word_mask;
+        }
+    } else {
+        // Single cell in the middle of the bottom row
+        uint mid = grid_width / 2;
+        (*grid)[grid_height - 1][mid >> 5] = 1u << (mid & 31);
+    }
+}
+
+// A row's cells with each one's left neighbour, itself and right neighbour in
+// its place, for the 32 cells of word k
+static inline void neighbours(const uint32_t *row, uint k, uint32_t *left, uint32_t *centre, uint32_t *right) {
+    *centre = row[k];
+    *left = (row[k] << 1) | (k ? row[k - 1] >> 31 : 0);
+    *right = (row[k] >> 1) | ((k + 1 < grid_words) ? row[k + 1] << 31 : 0);
+}
+
+// Bitwise full adder
+static inline void add3(uint32_t a, uint32_t b, uint32_t c, uint32_t *sum, uint32_t *carry) {
+    uint32_t ab = a ^ b;
+    *sum = ab ^ c;
+    *carry = (a & b) | (ab & c);
+}
+
+// Conway's Life from src into dst (which may be prev). Returns true if dst
+// differs from prev, the generation before src
+static bool step_life(const grid_t *src, const grid_t *prev, grid_t *dst) {
+    uint32_t changed = 0;
+    for(uint y = 0; y < grid_height; y++) {
+        const uint32_t *up = y ? (*src)[y - 1] : empty_row;
+        const uint32_t *mid = (*src)[y];
+        const uint32_t *down = (y + 1 < grid_height) ? (*src)[y + 1] : empty_row;
+
+        for(uint k = 0; k < grid_words; k++) {
+            uint32_t ul, u, ur, l, cell, r, dl, d, dr;
+            neighbours(up, k, &ul, &u, &ur);
+            neighbours(mid, k, &l, &cell, &r);
+            neighbours(down, k, &dl, &d, &dr);
+
+            // Sum the eight neighbours into bit planes for 1s, 2s and 4s-or-more
+            uint32_t s0, c0, s1, c1, s2, c2, ones, c3, t, c4, twos, c5;
+            add3(ul, u, ur, &s0, &c0);
+            add3(l, r, dl, &s1, &c1);
+            s2 = d ^ dr;
+            c2 = d & dr;
+            add3(s0, s1, s2, &ones, &c3);
+            add3(c0, c1, c2, &t, &c4);
+            twos = t ^ c3;
+            c5 = t & c3;
+            uint32_t fours = c4 | c5;
+
+            // Born with 3 neighbours, survives with 2 or 3
+            uint32_t next = twos & ~fours & (ones | cell);
+            if(k == grid_words - 1u) {
+                next &= last_word_mask;
+            }
+            changed |= next ^ (*prev)[y][k];
+            (*dst)[y][k] = next;
+        }
+    }
+    return changed != 0;
+}
+
+// Elementary rule from src into dst: scroll up a row and add the next
+// generation of the bottom row
+static void step_elementary(const grid_t *src, grid_t *dst) {
+    memcpy((*dst)[0], (*src)[1], (grid_height - 1) * sizeof((*src)[0]));
+
+    const uint32_t *last = (*src)[grid_height - 1];
+    uint32_t *next = (*dst)[grid_height - 1];
+    for(uint k = 0; k < grid_words; k++) {
+        uint32_t l, c, r;
+        neighbours(last, k, &l, &c, &r);
+
+        // OR together the neighbourhood patterns (left, centre, right as bits 2-0) the rule sets
+        uint32_t out = 0;
+        for(uint pattern = 0; pattern < 8; pattern++) {
+            if(rule & (1u << pattern)) {
+                out |= ((pattern & 4) ? l : ~l) & ((pattern & 2) ? c : ~c) & ((pattern & 1) ? r : ~r);
+            }
+        }
+        next[k] = (k == grid_words - 1u) ? out & last_word_mask : out;
+    }
+}
+
+void life_init(void) {
+    cell_size = 1;
+    while(wall_width > GRID_MAX_WIDTH * cell_size || wall_height > GRID_MAX_HEIGHT * cell_size) {
+        cell_size++;
+    }
+    grid_width = wall_width / cell_size;
+    grid_height = wall_height / cell_size;
+    grid_words = (grid_width + 31) / 32;
+    last_word_mask = (grid_width & 31) ? (1u << (grid_width & 31)) - 1 : 0xffffffff;
+
+    rule = param(PARAM_CA_RULE);
+    seed(&grids[0]);
+    memcpy(&grids[1], &grids[0], sizeof(grid_t));
+}
+
+// Next generation from src into dst, reseeding on a change of rule or when
+// Life has settled
+static void generation(const grid_t *src, const grid_t *prev, grid_t *dst) {
+    if(param(PARAM_CA_RULE) != rule) {
+        rule = param(PARAM_CA_RULE);
+        seed(dst);
+        still_generations = 0;
+    } else if(rule != LIFE_RULE_GAME_OF_LIFE) {
+        step_elementary(src, dst);
+    } else if(step_life(src, prev, dst)) {
+        still_generations = 0;
+    } else if(++still_generations == STILL_LIMIT) {
+        seed(dst);
+        still_generations = 0;
+    }
+}
+
+void life_poll(void) {
+    // Wait for core 1 to pick up the last generation, and only step while the
+    // effect is on screen
+    uint steps;
+    if(!regions_show_demo(DEMO_LIFE) || !(steps = handoff_begin_step(&handoff))) {
+        return;
+    }
+
+    // One generation per step, alternating between the back buffer (which
+    // holds the generation before the front one) and the scratch grid so the
+    // last lands in the back buffer
+    int8_t back = handoff_back(&handoff);
+    const grid_t *src = &grids[handoff.front];
+    const grid_t *prev = &grids[back];
+    for(uint n = steps; n > 0; n--) {
+        grid_t *dst = &grids[(n & 1) ? back : SCRATCH_GRID];
+        generation(src, prev, dst);
+        prev = src;
+        src = dst;
+    }
+
+    handoff_publish(&handoff);
+}
+
+void life_begin_frame(void) {
+    handoff_take(&handoff);
+}
+
+// First cell from cell onwards that isn't alive (or dead, if alive is false)
+static uint16_t __render_func(run_end)(const uint32_t *row, uint16_t cell, bool alive) {
+    uint32_t flip = alive ? 0xffffffff : 0;
+    uint k = cell >> 5;
+    uint32_t diff = (row[k] ^ flip) & (0xffffffffu << (cell & 31));
+    while(!diff) {
+        if(++k == grid_words) {
+            return grid_width;
+        }
+        diff = row[k] ^ flip;
+    }
+    return MIN(k * 32 + __builtin_ctz(diff), grid_width);
+}
+
+// Whether a cell of row is alive
+static inline bool cell_alive(const uint32_t *row, uint16_t cell) {
+    return (row[cell >> 5] >> (cell & 31)) & 1;
+}
+
+// Pixel x of the grid up to which cells match the one under x (at most grid_end)
+static inline uint16_t pixel_run_end(const uint32_t *row, uint16_t x, uint16_t grid_end) {
+    uint16_t cell = x / cell_size;
+    return MIN(run_end(row, cell, cell_alive(row, cell)) * cell_size, grid_end);
+}
+
+uint16_t *__render_func(life_span)(uint16_t *p, uint16_t y, uint16_t x0, uint16_t x1, uint16_t color) {
+    uint16_t cell_y = y / cell_size;
+    uint16_t grid_end = MIN(grid_width * cell_size, x1);
+    uint16_t x = x0;
+
+    if(cell_y < grid_height) {
+        const uint32_t *row = grids[handoff.front][cell_y];
+        while(x < grid_end) {
+            uint16_t end = pixel_run_end(row, x, grid_end);
+            if(end - x >= MIN_COLOR_RUN) {
+                p = span_color(p, cell_alive(row, x / cell_size) ? color : 0, end - x);
+                x = end;
+                continue;
+            }
+
+            // Short runs up to the next long one, as one raw span
+            uint16_t start = x;
+            do {
+                x = end;
+            } while(x < grid_end && (end = pixel_run_end(row, x, grid_end)) - x < MIN_COLOR_RUN);
+            uint16_t *first = p + 1;
+            p = span_raw_begin(p, x - start);
+            *first = cell_alive(row, start / cell_size) ? color : 0;
+            for(uint16_t k = start + 1; k < x; k++) {
+                *p++ = cell_alive(row, k / cell_size) ? color : 0;
+            }
+        }
+    }
+
+    // Black past the edge of the grid
+    return span_color(p, 0, x1 - x);
+}
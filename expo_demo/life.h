@@ -0,0 +1,34 @@
+// Cellular automaton effect
+//
+// The grid is bit-packed, 32 cells per word. Core 0 works out one generation
+// per frame into a back buffer, 32 cells at a time: the eight neighbours of
+// every cell in a word are summed with bitwise adders, so there is no loop
+// over cells. Core 1 picks up the newest grid at the frame boundary and draws
+// each line as color runs found by scanning the words for the next change.
+//
+// The grid is the screen size up to 320x240 cells; larger modes draw each
+// cell as a block of pixels.
+
+#ifndef LIFE_H
+#define LIFE_H
+
+#include "pico.h"
+
+// PARAM_CA_RULE is LIFE_RULE_GAME_OF_LIFE for Conway's Life, or an elementary
+// (one-dimensional) rule number 1-255 whose generations scroll up the screen
+#define LIFE_RULE_GAME_OF_LIFE 0
+
+// Seed the grid (call once before drawing)
+void life_init(void);
+
+// Work out the next generation if the effect is on screen and core 1 has
+// picked up the last one (core 0, call often)
+void life_poll(void);
+
+// Switch to the newest generation (core 1, at frame boundary)
+void life_begin_frame(void);
+
+// Write pixels x0 to x1 (exclusive) of line y, alive cells in color
+uint16_t *life_span(uint16_t *p, uint16_t y, uint16_t x0, uint16_t x1, uint16_t color);
+
+#endif
@@ -0,0 +1,166 @@
+#include "modulation.h"
+#include "params.h"
+#include "wall.h"
+#include "trig.h"
+#include "handoff.h"
+#include "rng.h"
+#include <string.h>
+
+// Routes in one preset
+#define MOD_ROUTES 4
+
+// Full scale of a source (sources are Q15, LFOs -1..1, envelopes and pots 0..1)
+#define MOD_ONE 32767
+
+enum {
+    SOURCE_NONE,
+    SOURCE_SINE,
+    SOURCE_TRIANGLE,
+    SOURCE_SAW,
+    SOURCE_SQUARE,
+    SOURCE_SAMPLE_HOLD,
+    SOURCE_ENVELOPE, // Attack and decay, started by each change of PARAM_DEMO
+    SOURCE_POT0,
+    SOURCE_POT1,
+};
+
+typedef struct {
+    uint8_t source;
+    uint8_t target;
+    // Frames per LFO cycle, or for an envelope its attack plus decay
+    uint16_t period;
+    // Change of the target parameter at full scale
+    int16_t depth;
+} route_t;
+
+static const route_t presets[MOD_COUNT][MOD_ROUTES] = {
+    [MOD_DRIFT] = {
+        {SOURCE_SINE, PARAM_PLASMA_SCALE, 600, 3},
+        {SOURCE_TRIANGLE, PARAM_SCROLL_DY, 900, 2},
+        {SOURCE_SINE, PARAM_PARTICLES, 420, 192},
+        {SOURCE_TRIANGLE, PARAM_SCROLL_DX, 1300, 2},
+    },
+    [MOD_PULSE] = {
+        {SOURCE_SQUARE, PARAM_BLOCK_SIZE, 120, -64},
+        {SOURCE_SAW, PARAM_SPEED_INC, 240, 2},
+        {SOURCE_ENVELOPE, PARAM_PALETTE_CYCLE, 90, 8},
+        {SOURCE_ENVELOPE, PARAM_NOISE_MIX, 40, 160},
+    },
+    [MOD_JITTER] = {
+        {SOURCE_SAMPLE_HOLD, PARAM_PATTERN_MASK, 30, 15},
+        {SOURCE_SAMPLE_HOLD, PARAM_PLASMA_SCALE, 45, 3},
+        {SOURCE_POT0, PARAM_PARTICLES, 0, 512},
+        {SOURCE_POT1, PARAM_WOBBLE_DEPTH, 0, 32},
+    },
+};
+
+// Offsets for one frame, and the parameters they apply to
+typedef struct {
+    int16_t offsets[PARAM_COUNT];
+    uint32_t mask;
+} mod_frame_t;
+
+// Offsets core 1 is applying and the ones core 0 works out
+static mod_frame_t frames[2];
+static handoff_t handoff = HANDOFF_INIT;
+
+// Core 0 state: each route's phase (Q16 fraction of a cycle), held sample
+// and frames since its envelope started
+static uint16_t phases[MOD_ROUTES];
+static int16_t held[MOD_ROUTES];
+static uint16_t envelope_frames = 0xffff;
+static uint16_t last_demo = 0xffff;
+static uint32_t rng = 0x6c078965;
+
+// Attack over the first eighth of the period, then decay to nothing
+static int32_t envelope(uint16_t period) {
+    uint16_t attack = MAX(period / 8, 1);
+    if(envelope_frames < attack) {
+        return MOD_ONE * envelope_frames / attack;
+    }
+    if(envelope_frames >= period) {
+        return 0;
+    }
+    return MOD_ONE * (period - envelope_frames) / (period - attack);
+}
+
+// Value of route n's source this frame, after moving its phase on by rate percent of a step
+static int32_t source_value(uint n, const route_t *route, uint16_t rate) {
+    uint16_t phase = phases[n];
+    if(route->period) {
+        uint16_t step = MAX(65536u * rate / (100u * route->period), 1);
+        phases[n] = phase + step;
+        // A new sample each time the cycle wraps
+        if(phases[n] < phase) {
+            held[n] = (int16_t)rng_next(&rng);
+        }
+    }
+
+    switch(route->source) {
+        case SOURCE_SINE:
+            return trig_sin[phase >> 8] * MOD_ONE / TRIG_ONE;
+        case SOURCE_TRIANGLE:
+            return (phase < 32768) ? 2 * phase - 32768 : 32767 - 2 * (phase - 32768);
+        case SOURCE_SAW:
+            return phase - 32768;
+        case SOURCE_SQUARE:
+            return (phase < 32768) ? MOD_ONE : -MOD_ONE;
+        case SOURCE_SAMPLE_HOLD:
+            return held[n];
+        case SOURCE_ENVELOPE:
+            return envelope(route->period);
+        case SOURCE_POT0:
+        case SOURCE_POT1:
+            // 12-bit readings, the leader's on a video wall
+            return wall_pot(route->source - SOURCE_POT0) << 3;
+        default:
+            return 0;
+    }
+}
+
+static void step(mod_frame_t *frame) {
+    memset(frame, 0, sizeof(*frame));
+
+    // Envelopes start again on every change of demo
+    if(param(PARAM_DEMO) != last_demo) {
+        last_demo = param(PARAM_DEMO);
+        envelope_frames = 0;
+    } else if(envelope_frames < 0xffff) {
+        envelope_frames++;
+    }
+
+    uint8_t preset = param(PARAM_MOD);
+    uint16_t depth = param(PARAM_MOD_DEPTH);
+    uint16_t rate = param(PARAM_MOD_RATE);
+    for(uint n = 0; n < MOD_ROUTES; n++) {
+        const route_t *route = &presets[preset][n];
+        if(route->source == SOURCE_NONE) {
+            continue;
+        }
+        int32_t value = source_value(n, route, rate);
+        int32_t offset = (value * route->depth / MOD_ONE) * depth / 100;
+        frame->offsets[route->target] += offset;
+        frame->mask |= 1u << route->target;
+    }
+}
+
+void modulation_poll(void) {
+    // Wait for core 1 to pick up the last offsets, then step once for each
+    // frame since (only the last step's offsets are kept)
+    uint steps = handoff_begin_step(&handoff);
+    if(!steps) {
+        return;
+    }
+    mod_frame_t *frame = &frames[handoff_back(&handoff)];
+    while(steps--) {
+        step(frame);
+    }
+    handoff_publish(&handoff);
+}
+
+void modulation_begin_frame(void) {
+    handoff_take(&handoff);
+    // Applied every frame, since the values underneath may have just changed
+    const mod_frame_t *frame = &frames[handoff.front];
+    params_modulate(frame->offsets, frame->mask);
+}
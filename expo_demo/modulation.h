@@ -0,0 +1,33 @@
+// Parameter modulation
+//
+// A modulation preset is a small routing matrix: each route takes a source
+// (an LFO of one of five shapes, an envelope or a pot) and adds it, scaled by
+// its depth, to one parameter. Core 0 steps every source and sums the routes
+// once per frame, and publishes the offsets for all parameters together.
+// Core 1 applies them at the frame boundary on top of the values set by the
+// pots and USB, so modulated parameters cost nothing on the scanline path and
+// switch all at once between frames.
+
+#ifndef MODULATION_H
+#define MODULATION_H
+
+#include "pico.h"
+
+// Values of PARAM_MOD
+enum {
+    MOD_OFF,
+    MOD_DRIFT,  // Slow sines and triangles on scale, scroll and particle count
+    MOD_PULSE,  // Square and saw on block size and speed, a color and static burst on each demo change
+    MOD_JITTER, // Sample and hold on pattern and scale, pot 0 on particle count
+    MOD_COUNT
+};
+
+// Step the sources and publish the next frame's offsets if core 1 has picked
+// up the last ones (core 0, call often)
+void modulation_poll(void);
+
+// Apply the newest offsets to the live parameters (core 1, at frame boundary
+// straight after params_apply_pending)
+void modulation_begin_frame(void);
+
+#endif
@@ -0,0 +1,209 @@
+#include "noise.h"
+#include "span.h"
+#include "params.h"
+#include "governor.h"
+#include "wall.h"
+#include "rng.h"
+#include "placement.h"
+
+// Outputs (pairs of pixels or cells) per seeded chunk of a line
+#define CHUNK_PAIRS 32
+
+// A halfword in both halves of a word
+#define PAIR(h) ((uint32_t)(h) * 0x00010001u)
+
+// Multiplier spreading a 5-bit level to all three channels of a pixel
+#define GRAY PICO_SCANVIDEO_PIXEL_FROM_RGB5(1, 1, 1)
+
+// Controls for the frame being drawn
+typedef struct {
+    uint32_t channels; // Channel bits shown, in both halves
+    uint16_t density;
+    bool color;
+    bool half;         // One random pixel in two, doubled
+} noise_settings_t;
+
+static noise_settings_t settings;
+static uint32_t frame_seed;
+static uint16_t cell;
+static uint16_t mix;
+
+// Pairs of one line, from a chunk's seed on
+typedef struct {
+    noise_settings_t settings;
+    uint32_t rng;
+    uint32_t row_seed;
+    uint16_t chunk;
+    uint16_t left; // Pairs left in the chunk
+    // Right cell of the last pair, still to be drawn (2-pixel cells)
+    uint32_t spare;
+    bool has_spare;
+} noise_gen_t;
+
+void noise_begin_frame(void) {
+    // The same on every board of a video wall
+    frame_seed = rng_hash(wall_frame + 1);
+
+    uint8_t mask = param(PARAM_PATTERN_MASK);
+    uint8_t shown = (mask & 7) ? (mask & 7) : 7;
+    settings.channels = PAIR(PICO_SCANVIDEO_PIXEL_FROM_RGB5((shown & 1) ? 0x1f : 0, (shown & 2) ? 0x1f : 0,
+                                                            (shown & 4) ? 0x1f : 0));
+    settings.color = mask & 8;
+    settings.density = param(PARAM_NOISE_DENSITY);
+    cell = MAX(param(PARAM_BLOCK_SIZE) >> 3, 1);
+    settings.half = governor_half_width() && cell == 1;
+    mix = governor_demo_fit[DEMO_NOISE] ? param(PARAM_NOISE_MIX) : 0;
+}
+
+// Seed the generator for the start of its chunk (xorshift32 never leaves 0,
+// so seeds are odd)
+static inline void seed_chunk(noise_gen_t *g) {
+    g->rng = rng_hash(g->row_seed + g->chunk * 0x9e3779b9u) | 1;
+    g->left = CHUNK_PAIRS;
+}
+
+// Two pixels, the left one in the low half
+static __force_inline uint32_t next_pair(noise_gen_t *g) {
+    if(!g->left) {
+        g->chunk++;
+        seed_chunk(g);
+    }
+    g->left--;
+
+    const noise_settings_t *s = &g->settings;
+    uint32_t w = rng_next(&g->rng);
+    if(s->half) {
+        w = PAIR(w);
+    }
+    // Five random bits per channel, or five per pixel spread to every channel
+    uint32_t pair = s->color ? w : (w & PAIR(0x1f)) * GRAY;
+    pair &= s->channels;
+
+    if(s->density < NOISE_ALL) {
+        // A byte per pixel with bit 8 set, so the subtract borrows within the
+        // half, and leaves bit 8 clear where the byte is below the density
+        uint32_t b = (rng_next(&g->rng) & PAIR(0xff)) | PAIR(0x100);
+        if(s->half) {
+            b = PAIR(b);
+        }
+        uint32_t unlit = ((b - PAIR(s->density)) >> 8) & PAIR(1);
+        pair &= (unlit ^ PAIR(1)) * 0xffff;
+    }
+    return pair;
+}
+
+// Start at pair k of a row of cells, skipping to it within its chunk
+static inline void start_row(noise_gen_t *g, uint32_t row, uint32_t k) {
+    g->settings = settings;
+    g->row_seed = rng_hash(row ^ frame_seed);
+    g->chunk = k / CHUNK_PAIRS;
+    g->spare = 0;
+    g->has_spare = false;
+    seed_chunk(g);
+    for(uint n = k % CHUNK_PAIRS; n; n--) {
+        next_pair(g);
+    }
+}
+
+// Next two pixels of a line of 2-pixel cells, each output covering two pairs
+static __force_inline uint32_t next_doubled(noise_gen_t *g) {
+    if(g->has_spare) {
+        g->has_spare = false;
+        return PAIR(g->spare >> 16);
+    }
+    g->spare = next_pair(g);
+    g->has_spare = true;
+    return PAIR(g->spare & 0xffff);
+}
+
+// Next two pixels of a line of 1-pixel cells, or of 2-pixel cells if doubled
+static __force_inline uint32_t next_pixels(noise_gen_t *g, bool doubled) {
+    return doubled ? next_doubled(g) : next_pair(g);
+}
+
+// Pixels x0 to x1 of a line of 1-pixel cells (or 2-pixel cells if doubled)
+// from q, a word store per pair of pixels once q and the pairs line up
+// (doubled is a constant at each call, so each cell size gets its own loop)
+static __force_inline uint16_t *write_pixels(uint16_t *q, noise_gen_t *g, uint16_t x0, uint16_t x1, bool doubled) {
+    uint16_t n = x1 - x0;
+    // Whether the next pixel is the right one of its pair, and that pixel if so
+    bool odd = x0 & 1;
+    uint32_t held = odd ? next_pixels(g, doubled) >> 16 : 0;
+
+    if(!span_aligned(q)) {
+        // One pixel on its own brings q to a word
+        if(!odd) {
+            held = next_pixels(g, doubled);
+        }
+        *q++ = held;
+        held >>= 16;
+        odd = !odd;
+        n--;
+    }
+
+    if(odd) {
+        // Each word holds the right pixel of one pair and the left of the next
+        for(; n >= 2; n -= 2) {
+            uint32_t pair = next_pixels(g, doubled);
+            *(span_word_t *)q = held | (pair << 16);
+            q += 2;
+            held = pair >> 16;
+        }
+        if(n) {
+            *q++ = held;
+        }
+    } else {
+        for(; n >= 2; n -= 2) {
+            *(span_word_t *)q = next_pixels(g, doubled);
+            q += 2;
+        }
+        if(n) {
+            *q++ = next_pixels(g, doubled);
+        }
+    }
+    return q;
+}
+
+uint16_t *__render_func(noise_span)(uint16_t *p, uint16_t y, uint16_t x0, uint16_t x1) {
+    if(x1 <= x0) {
+        return p;
+    }
+    noise_gen_t g;
+
+    // Cells too narrow for color runs (which would take 3 halfwords for 1 or
+    // 2 pixels) as one raw span
+    if(cell < 3) {
+        uint16_t len = x1 - x0;
+        uint16_t *q = span_raw_stream(p, len);
+        if(cell == 1) {
+            start_row(&g, y, x0 / 2);
+            write_pixels(q, &g, x0, x1, false);
+        } else {
+            // Skip the left pair of pixels of the first output if x0 is in its right one
+            start_row(&g, y / 2, x0 / 4);
+            if(x0 & 2) {
+                next_doubled(&g);
+            }
+            write_pixels(q, &g, x0, x1, true);
+        }
+        return span_raw_end(p, len);
+    }
+
+    // A color run per cell, two cells from each pair
+    uint32_t c = x0 / cell;
+    start_row(&g, y / cell, c / 2);
+    uint32_t pair = next_pair(&g) >> ((c & 1) * 16);
+    for(uint16_t x = x0; x < x1;) {
+        uint16_t end = MIN((c + 1) * cell, x1);
+        p = span_color(p, pair, end - x);
+        x = end;
+        c++;
+        pair = (c & 1) ? pair >> 16 : next_pair(&g);
+    }
+    return p;
+}
+
+bool __render_func(noise_mixes)(uint16_t y) {
+    // A second hash of the row, so which rows are replaced doesn't follow the noise in them
+    return mix && (rng_hash((y / cell) ^ ~frame_seed) & 0xff) < mix;
+}
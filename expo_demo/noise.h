@@ -0,0 +1,38 @@
+// Video noise: static, snow and glitch lines
+//
+// Pixels come from xorshift32 two at a time. The two halfwords of each output
+// are masked and spread into two RGB555 pixels together (SIMD within a
+// register), and where not every pixel is lit a second output gives a byte per
+// pixel, compared against the density in both halves at once with one
+// subtract. Each line is cut into chunks seeded from a hash of the chunk's
+// place and the frame, so a span can start anywhere after skipping less than a
+// chunk, and a video wall shows one picture.
+//
+// The noise demo fills its area with cells of noise. The mix layer replaces
+// rows of cells of whatever demos are showing with the same noise, as glitch
+// lines over the picture. The controls follow pot 0 with the other demos':
+//   PARAM_NOISE_DENSITY  Lit cells in 256ths (unlit cells are black)
+//   PARAM_BLOCK_SIZE     Cells are an eighth of the block size across and down
+//   PARAM_PATTERN_MASK   Bits 0-2 the red, green and blue channels shown (none
+//                        shows all three), bit 3 set for independent channels
+//                        instead of gray levels
+//   PARAM_NOISE_MIX      Rows of cells replaced by the mix layer, in 256ths
+
+#ifndef NOISE_H
+#define NOISE_H
+
+#include "pico.h"
+
+// Largest PARAM_NOISE_DENSITY and PARAM_NOISE_MIX (every cell or row)
+#define NOISE_ALL 256
+
+// Pick up the controls and a new seed for this frame (core 1, at frame boundary)
+void noise_begin_frame(void);
+
+// Write pixels x0 to x1 (exclusive) of canvas line y of the noise demo
+uint16_t *noise_span(uint16_t *p, uint16_t y, uint16_t x0, uint16_t x1);
+
+// Whether the mix layer replaces canvas line y this frame
+bool noise_mixes(uint16_t y);
+
+#endif
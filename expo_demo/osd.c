@@ -0,0 +1,240 @@
+#include "osd.h"
+#include "span.h"
+#include "params.h"
+#include "effects.h"
+#include "telemetry.h"
+#include "governor.h"
+#include "handoff.h"
+#include "placement.h"
+#include <stdio.h>
+
+// Glyphs are 5x7 with one pixel of spacing
+#define CHAR_WIDTH 6
+#define CHAR_HEIGHT 8
+#define OSD_PAD 2
+#define BAR_HEIGHT 4
+
+// Panel position and size in pixels (needs a mode at least 103 pixels wide)
+#define OSD_X 4
+#define OSD_Y 4
+#define OSD_WIDTH (2 * OSD_PAD + OSD_COLUMNS * CHAR_WIDTH - 1)
+#define OSD_HEIGHT (2 * OSD_PAD + OSD_TEXT_ROWS * CHAR_HEIGHT + BAR_HEIGHT)
+
+// Worst case tokens for one row (alternating single pixels and short runs)
+#define OSD_ROW_TOKENS (OSD_WIDTH * 5 / 4 + 4)
+
+#define OSD_FG PICO_SCANVIDEO_PIXEL_FROM_RGB5(0x1f, 0x1f, 0x1f)
+#define OSD_BG PICO_SCANVIDEO_PIXEL_FROM_RGB5(0, 0, 0x08)
+#define OSD_BAR_TRACK PICO_SCANVIDEO_PIXEL_FROM_RGB5(0x08, 0x08, 0x08)
+#define OSD_BAR_OK PICO_SCANVIDEO_PIXEL_FROM_RGB5(0, 0x1f, 0)
+#define OSD_BAR_LOW PICO_SCANVIDEO_PIXEL_FROM_RGB5(0x1f, 0, 0)
+#define OSD_BAR_REDUCED PICO_SCANVIDEO_PIXEL_FROM_RGB5(0x1f, 0x1f, 0)
+
+// 5x7 font for ' ' to 'Z', one byte per row with bit 4 as the leftmost pixel
+static const uint8_t font[][7] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // ' '
+    {0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04}, // '!'
+    {0x0a, 0x0a, 0x00, 0x00, 0x00, 0x00, 0x00}, // '"'
+    {0x0a, 0x1f, 0x0a, 0x0a, 0x0a, 0x1f, 0x0a}, // '#'
+    {0x04, 0x0f, 0x14, 0x0e, 0x05, 0x1e, 0x04}, // '$'
+    {0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03}, // '%'
+    {0x0c, 0x12, 0x14, 0x08, 0x15, 0x12, 0x0d}, // '&'
+    {0x04, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00}, // '''
+    {0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02}, // '('
+    {0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08}, // ')'
+    {0x00, 0x04, 0x15, 0x0e, 0x15, 0x04, 0x00}, // '*'
+    {0x00, 0x04, 0x04, 0x1f, 0x04, 0x04, 0x00}, // '+'
+    {0x00, 0x00, 0x00, 0x00, 0x0c, 0x04, 0x08}, // ','
+    {0x00, 0x00, 0x00, 0x1f, 0x00, 0x00, 0x00}, // '-'
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x0c, 0x0c}, // '.'
+    {0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00}, // '/'
+    {0x0e, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0e}, // '0'
+    {0x04, 0x0c, 0x04, 0x04, 0x04, 0x04, 0x0e}, // '1'
+    {0x0e, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1f}, // '2'
+    {0x1f, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0e}, // '3'
+    {0x02, 0x06, 0x0a, 0x12, 0x1f, 0x02, 0x02}, // '4'
+    {0x1f, 0x10, 0x1e, 0x01, 0x01, 0x11, 0x0e}, // '5'
+    {0x06, 0x08, 0x10, 0x1e, 0x11, 0x11, 0x0e}, // '6'
+    {0x1f, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08}, // '7'
+    {0x0e, 0x11, 0x11, 0x0e, 0x11, 0x11, 0x0e}, // '8'
+    {0x0e, 0x11, 0x11, 0x0f, 0x01, 0x02, 0x0c}, // '9'
+    {0x00, 0x0c, 0x0c, 0x00, 0x0c, 0x0c, 0x00}, // ':'
+    {0x00, 0x0c, 0x0c, 0x00, 0x0c, 0x04, 0x08}, // ';'
+    {0x02, 0x04, 0x08, 0x10, 0x08, 0x04, 0x02}, // '<'
+    {0x00, 0x00, 0x1f, 0x00, 0x1f, 0x00, 0x00}, // '='
+    {0x08, 0x04, 0x02, 0x01, 0x02, 0x04, 0x08}, // '>'
+    {0x0e, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04}, // '?'
+    {0x0e, 0x11, 0x01, 0x0d, 0x15, 0x15, 0x0e}, // '@'
+    {0x0e, 0x11, 0x11, 0x11, 0x1f, 0x11, 0x11}, // 'A'
+    {0x1e, 0x11, 0x11, 0x1e, 0x11, 0x11, 0x1e}, // 'B'
+    {0x0e, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0e}, // 'C'
+    {0x1c, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1c}, // 'D'
+    {0x1f, 0x10, 0x10, 0x1e, 0x10, 0x10, 0x1f}, // 'E'
+    {0x1f, 0x10, 0x10, 0x1e, 0x10, 0x10, 0x10}, // 'F'
+    {0x0e, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0f}, // 'G'
+    {0x11, 0x11, 0x11, 0x1f, 0x11, 0x11, 0x11}, // 'H'
+    {0x0e, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0e}, // 'I'
+    {0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0c}, // 'J'
+    {0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11}, // 'K'
+    {0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1f}, // 'L'
+    {0x11, 0x1b, 0x15, 0x15, 0x11, 0x11, 0x11}, // 'M'
+    {0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11}, // 'N'
+    {0x0e, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0e}, // 'O'
+    {0x1e, 0x11, 0x11, 0x1e, 0x10, 0x10, 0x10}, // 'P'
+    {0x0e, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0d}, // 'Q'
+    {0x1e, 0x11, 0x11, 0x1e, 0x14, 0x12, 0x11}, // 'R'
+    {0x0f, 0x10, 0x10, 0x0e, 0x01, 0x01, 0x1e}, // 'S'
+    {0x1f, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04}, // 'T'
+    {0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0e}, // 'U'
+    {0x11, 0x11, 0x11, 0x11, 0x11, 0x0a, 0x04}, // 'V'
+    {0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0a}, // 'W'
+    {0x11, 0x11, 0x0a, 0x04, 0x0a, 0x11, 0x11}, // 'X'
+    {0x11, 0x11, 0x11, 0x0a, 0x04, 0x04, 0x04}, // 'Y'
+    {0x1f, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1f}, // 'Z'
+};
+
+// Panel as pre-encoded tokens, rows packed back to back
+typedef struct {
+    uint16_t row_start[OSD_HEIGHT + 1];
+    uint16_t tokens[OSD_HEIGHT * OSD_ROW_TOKENS];
+} osd_panel_t;
+
+// Panel core 1 is drawing from (none before the first one is built) and the
+// one core 0 builds. Panels follow the stats rather than the wall frame, so
+// only the handoff itself is shared
+static osd_panel_t panels[2];
+static handoff_t handoff = {.front = -1, .ready = -1};
+// Whether core 1 draws the panel this frame
+static bool visible;
+
+static uint32_t last_built_frame = 0xffffffff;
+
+// Set one pixel row of text into px (row 0..6 of the glyphs)
+static void text_row(uint16_t *px, const char *text, uint row) {
+    for(uint col = 0; col < OSD_COLUMNS && text[col]; col++) {
+        char c = text[col];
+        if(c >= 'a' && c <= 'z') {
+            c -= 'a' - 'A';
+        }
+        if(c < ' ' || c > 'Z') {
+            c = ' ';
+        }
+        uint8_t bits = font[c - ' '][row];
+        for(uint b = 0; b < 5; b++) {
+            if(bits & (0x10 >> b)) {
+                px[col * CHAR_WIDTH + b] = OSD_FG;
+            }
+        }
+    }
+}
+
+// Number of pixels from x with the same color as px[x]
+static uint run_length(const uint16_t *px, uint x, uint w) {
+    uint end = x + 1;
+    while(end < w && px[end] == px[x]) {
+        end++;
+    }
+    return end - x;
+}
+
+// Encode a row of pixels as color runs, grouping pixels that don't form a
+// run of at least 3 into raw spans
+static uint16_t *encode_row(uint16_t *p, const uint16_t *px, uint w) {
+    uint x = 0;
+    while(x < w) {
+        uint len = run_length(px, x, w);
+        if(len >= 3) {
+            p = span_color(p, px[x], len);
+            x += len;
+            continue;
+        }
+
+        uint start = x;
+        while(x < w && (len = run_length(px, x, w)) < 3) {
+            x += len;
+        }
+        uint16_t *first = p + 1;
+        p = span_raw_begin(p, x - start);
+        *first = px[start];
+        for(uint k = start + 1; k < x; k++) {
+            *p++ = px[k];
+        }
+    }
+    return p;
+}
+
+static void build_panel(osd_panel_t *panel) {
+    // Lines longer than OSD_COLUMNS are cut off when drawn
+    char text[OSD_TEXT_ROWS][32];
+    snprintf(text[0], sizeof(text[0]), "%s", effects[param(PARAM_DEMO)].name);
+    snprintf(text[1], sizeof(text[1]), "SPD %u/%u BLK %u",
+             param(PARAM_SPEED_INC), param(PARAM_SPEED_FRAME), param(PARAM_BLOCK_SIZE));
+    snprintf(text[2], sizeof(text[2]), "HD %u%% %luUS Q%d",
+             render_stats.headroom_pct, (unsigned long)render_stats.line_max_us, render_stats.queue_min);
+    snprintf(text[3], sizeof(text[3]), "XIP %u%% M%lu",
+             render_stats.xip_hit_pct, (unsigned long)render_stats.xip_misses);
+
+    uint8_t headroom = render_stats.headroom_pct;
+    uint bar_width = (OSD_WIDTH - 2 * OSD_PAD) * headroom / 100;
+    uint16_t bar_color = (headroom >= 25 && !render_stats.late_lines) ? OSD_BAR_OK : OSD_BAR_LOW;
+    if(bar_color == OSD_BAR_OK && governor_level != RESOLUTION_FULL) {
+        // Keeping up, but only at reduced resolution
+        bar_color = OSD_BAR_REDUCED;
+    }
+
+    uint16_t *p = panel->tokens;
+    for(uint row = 0; row < OSD_HEIGHT; row++) {
+        uint16_t px[OSD_WIDTH];
+        for(uint x = 0; x < OSD_WIDTH; x++) {
+            px[x] = OSD_BG;
+        }
+
+        int text_y = row - OSD_PAD;
+        int bar_y = text_y - OSD_TEXT_ROWS * CHAR_HEIGHT;
+        if(text_y >= 0 && bar_y < 0 && text_y % CHAR_HEIGHT < 7) {
+            text_row(px + OSD_PAD, text[text_y / CHAR_HEIGHT], text_y % CHAR_HEIGHT);
+        } else if(bar_y >= 0 && bar_y < BAR_HEIGHT) {
+            for(uint x = 0; x < OSD_WIDTH - 2 * OSD_PAD; x++) {
+                px[OSD_PAD + x] = (x < bar_width) ? bar_color : OSD_BAR_TRACK;
+            }
+        }
+
+        panel->row_start[row] = p - panel->tokens;
+        p = encode_row(p, px, OSD_WIDTH);
+    }
+    panel->row_start[OSD_HEIGHT] = p - panel->tokens;
+}
+
+void osd_poll(void) {
+    // Wait for core 1 to pick up the last panel, and rebuild at most once a frame
+    if(handoff.ready >= 0 || !param(PARAM_OSD) || render_stats.frame == last_built_frame) {
+        return;
+    }
+    last_built_frame = render_stats.frame;
+
+    build_panel(&panels[handoff_back(&handoff)]);
+    handoff_publish(&handoff);
+}
+
+void osd_begin_frame(void) {
+    handoff_take(&handoff);
+    visible = param(PARAM_OSD) && handoff.front >= 0;
+}
+
+bool __render_func(osd_covers_line)(uint16_t y, uint16_t *x0, uint16_t *x1) {
+    if(!visible || y < OSD_Y || y >= OSD_Y + OSD_HEIGHT) {
+        return false;
+    }
+    *x0 = OSD_X;
+    *x1 = OSD_X + OSD_WIDTH;
+    return true;
+}
+
+uint16_t *__render_func(osd_span)(uint16_t *p, uint16_t y) {
+    const osd_panel_t *panel = &panels[handoff.front];
+    uint row = y - OSD_Y;
+    for(uint k = panel->row_start[row]; k < panel->row_start[row + 1]; k++) {
+        *p++ = panel->tokens[k];
+    }
+    return p;
+}
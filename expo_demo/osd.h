@@ -0,0 +1,29 @@
+// On-screen display
+//
+// A small panel showing the selected demo, its parameters, the render
+// headroom and the XIP cache hit rate. Core 0 draws the panel into a back buffer as ready-made
+// composable tokens, one token list per pixel row, and core 1 copies a row
+// into each line the panel covers. Lines outside the panel cost nothing.
+
+#ifndef OSD_H
+#define OSD_H
+
+#include "pico.h"
+
+// Panel size in characters
+#define OSD_COLUMNS 16
+#define OSD_TEXT_ROWS 4
+
+// Rebuild the panel if core 1 has picked up the last one (core 0, call often)
+void osd_poll(void);
+
+// Switch to the newest panel (core 1, at frame boundary)
+void osd_begin_frame(void);
+
+// Whether the panel covers line y, and if so its horizontal extent
+bool osd_covers_line(uint16_t y, uint16_t *x0, uint16_t *x1);
+
+// Copy the panel's tokens for line y (which must be covered)
+uint16_t *osd_span(uint16_t *p, uint16_t y);
+
+#endif
@@ -0,0 +1,89 @@
+#include "palette.h"
+#include "params.h"
+#include "persist.h"
+#include "placement.h"
+#include "pico/scanvideo.h"
+#include <math.h>
+
+uint16_t __render_table palette[PALETTE_SIZE];
+
+static uint16_t gradients[PALETTE_COUNT][PALETTE_SIZE];
+
+// Current rotation of the palette
+static uint8_t cycle;
+
+// Linear light (0..1) to a gamma-encoded 5-bit level
+static uint8_t gamma5(float c) {
+    if(c <= 0) {
+        return 0;
+    }
+    if(c >= 1) {
+        return 0x1f;
+    }
+    return (uint8_t)(0x1f * powf(c, 1 / 2.2f) + 0.5f);
+}
+
+static uint16_t pixel_linear(float r, float g, float b) {
+    return PICO_SCANVIDEO_PIXEL_FROM_RGB5(gamma5(r), gamma5(g), gamma5(b));
+}
+
+uint16_t palette_hsv(float h, float s, float v) {
+    h = (h - floorf(h)) * 6;
+    int sector = (int)h;
+    float f = h - sector;
+    float p = v * (1 - s);
+    float q = v * (1 - s * f);
+    float t = v * (1 - s * (1 - f));
+
+    switch(sector) {
+        case 0: return pixel_linear(v, t, p);
+        case 1: return pixel_linear(q, v, p);
+        case 2: return pixel_linear(p, v, t);
+        case 3: return pixel_linear(p, q, v);
+        case 4: return pixel_linear(t, p, v);
+        default: return pixel_linear(v, p, q);
+    }
+}
+
+// Position 0..1..0 across the palette, so gradients loop without a seam
+static float ping_pong(int n) {
+    return (n < PALETTE_SIZE / 2) ? n / (PALETTE_SIZE / 2.0f) : (PALETTE_SIZE - n) / (PALETTE_SIZE / 2.0f);
+}
+
+static void build_gradients(void) {
+    for(int n = 0; n < PALETTE_SIZE; n++) {
+        float angle = n * 2 * (float)M_PI / PALETTE_SIZE;
+        float t = ping_pong(n);
+
+        // Three phase-shifted sines so the palette wraps around smoothly
+        uint8_t r = (uint8_t)(15.5f + 15.5f * sinf(angle));
+        uint8_t g = (uint8_t)(15.5f + 15.5f * sinf(angle + 2 * (float)M_PI / 3));
+        uint8_t b = (uint8_t)(15.5f + 15.5f * sinf(angle + 4 * (float)M_PI / 3));
+        gradients[PALETTE_RAINBOW][n] = PICO_SCANVIDEO_PIXEL_FROM_RGB5(r, g, b);
+
+        gradients[PALETTE_HUE][n] = palette_hsv((float)n / PALETTE_SIZE, 1, 1);
+
+        // Red rises first, then green, then blue
+        gradients[PALETTE_FIRE][n] = pixel_linear(3 * t, 3 * t - 1, 3 * t - 2);
+        gradients[PALETTE_OCEAN][n] = pixel_linear(3 * t - 2, 3 * t - 1, 3 * t);
+        gradients[PALETTE_GREY][n] = pixel_linear(t, t, t);
+    }
+}
+
+void palette_init(void) {
+    if(!persist_table(PERSIST_TABLE_GRADIENTS, gradients, sizeof(gradients))) {
+        build_gradients();
+    }
+
+    cycle = 0;
+    palette_begin_frame(0);
+}
+
+void palette_begin_frame(uint steps) {
+    cycle += steps * param(PARAM_PALETTE_CYCLE);
+
+    const uint16_t *gradient = gradients[param(PARAM_PALETTE)];
+    for(uint n = 0; n < PALETTE_SIZE; n++) {
+        palette[n] = gradient[(uint8_t)(n + cycle)];
+    }
+}
@@ -0,0 +1,39 @@
+// Color palettes
+//
+// Indexed effects draw 8-bit values and look each one up in palette[] as they
+// write tokens. The gradients are built once at start-up. Each frame the
+// selected gradient is copied into palette[] rotated by the cycle position, so
+// color cycling and hue rotation cost 256 copies per frame rather than work
+// per pixel.
+
+#ifndef PALETTE_H
+#define PALETTE_H
+
+#include "pico.h"
+
+#define PALETTE_SIZE 256
+
+// Values of PARAM_PALETTE (every gradient loops, so it can be cycled)
+enum {
+    PALETTE_RAINBOW, // Three phase-shifted sines
+    PALETTE_HUE,     // Full-saturation hue wheel
+    PALETTE_FIRE,    // Black, red, yellow, white and back
+    PALETTE_OCEAN,   // Black, blue, cyan, white and back
+    PALETTE_GREY,    // Black to white and back
+    PALETTE_COUNT
+};
+
+// Live palette for the current frame (written by core 1 at frame boundary)
+extern uint16_t palette[PALETTE_SIZE];
+
+// Build the gradient tables (call once before drawing)
+void palette_init(void);
+
+// Advance the cycle by PARAM_PALETTE_CYCLE for each of steps animation steps
+// and fill palette[] (core 1, at frame boundary after params_apply_pending)
+void palette_begin_frame(uint steps);
+
+// Gamma-corrected RGB555 pixel from linear hue, saturation and value (0..1)
+uint16_t palette_hsv(float h, float s, float v);
+
+#endif
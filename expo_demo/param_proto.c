@@ -0,0 +1,88 @@
+#include "param_proto.h"
+
+// Decoder states
+enum {
+    DEC_SYNC,
+    DEC_COUNT,
+    DEC_ID,
+    DEC_LO,
+    DEC_HI,
+    DEC_SUM
+};
+
+void param_decoder_init(param_decoder_t *dec) {
+    dec->state = DEC_SYNC;
+    dec->count = 0;
+    dec->index = 0;
+    dec->sum = 0;
+    dec->errors = 0;
+}
+
+bool param_decoder_feed(param_decoder_t *dec, uint8_t byte) {
+    switch(dec->state) {
+        case DEC_SYNC:
+            if(byte == PARAM_PROTO_SYNC) {
+                dec->state = DEC_COUNT;
+            }
+            return false;
+        case DEC_COUNT:
+            if(byte == 0 || byte > PARAM_PROTO_MAX_UPDATES) {
+                // Not a valid header, resynchronize (byte may itself be a sync)
+                dec->errors++;
+                dec->state = (byte == PARAM_PROTO_SYNC) ? DEC_COUNT : DEC_SYNC;
+                return false;
+            }
+            dec->count = byte;
+            dec->index = 0;
+            dec->sum = byte;
+            dec->state = DEC_ID;
+            return false;
+        case DEC_ID:
+            dec->partial[0] = byte;
+            dec->sum += byte;
+            dec->state = DEC_LO;
+            return false;
+        case DEC_LO:
+            dec->partial[1] = byte;
+            dec->sum += byte;
+            dec->state = DEC_HI;
+            return false;
+        case DEC_HI:
+            dec->sum += byte;
+            dec->updates[dec->index].id = dec->partial[0];
+            dec->updates[dec->index].value = dec->partial[1] | ((uint16_t)byte << 8);
+            dec->index++;
+            dec->state = (dec->index == dec->count) ? DEC_SUM : DEC_ID;
+            return false;
+        default: // DEC_SUM
+            dec->state = DEC_SYNC;
+            if(byte != dec->sum) {
+                dec->errors++;
+                return false;
+            }
+            return true;
+    }
+}
+
+size_t param_proto_encode(uint8_t *out, const param_update_t *updates, uint8_t count) {
+    if(count == 0 || count > PARAM_PROTO_MAX_UPDATES) {
+        return 0;
+    }
+
+    uint8_t *p = out;
+    uint8_t sum = count;
+
+    *p++ = PARAM_PROTO_SYNC;
+    *p++ = count;
+    for(uint8_t n = 0; n < count; n++) {
+        uint8_t lo = updates[n].value & 0xff;
+        uint8_t hi = updates[n].value >> 8;
+        *p++ = updates[n].id;
+        *p++ = lo;
+        *p++ = hi;
+        sum += updates[n].id + lo + hi;
+    }
+    *p++ = sum;
+
+    return p - out;
+}
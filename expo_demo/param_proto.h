@@ -0,0 +1,48 @@
+// Binary parameter control protocol shared by the device and host tools
+//
+// Packet layout (all multi-byte values little endian):
+//   PARAM_PROTO_SYNC | count | count * (id, value lo, value hi) | checksum
+// Checksum is the 8-bit sum of every byte from count through the last value
+// byte. All updates in one packet form a batch and are applied together.
+
+#ifndef PARAM_PROTO_H
+#define PARAM_PROTO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define PARAM_PROTO_SYNC 0xa5
+// Maximum number of updates in a single batch
+#define PARAM_PROTO_MAX_UPDATES 32
+// Largest possible encoded packet
+#define PARAM_PROTO_MAX_PACKET (3 + 3 * PARAM_PROTO_MAX_UPDATES)
+
+// One parameter write
+typedef struct {
+    uint8_t id;
+    uint16_t value;
+} param_update_t;
+
+// Streaming decoder state (fed one byte at a time)
+typedef struct {
+    uint8_t state;
+    uint8_t count;
+    uint8_t index;
+    uint8_t sum;
+    uint8_t partial[2];
+    param_update_t updates[PARAM_PROTO_MAX_UPDATES];
+    uint32_t errors; // Number of packets dropped due to bad count or checksum
+} param_decoder_t;
+
+void param_decoder_init(param_decoder_t *dec);
+
+// Feed one received byte, returns true when dec->updates holds a complete
+// batch of dec->count updates (valid until the next call)
+bool param_decoder_feed(param_decoder_t *dec, uint8_t byte);
+
+// Encode a batch into out (at least PARAM_PROTO_MAX_PACKET bytes), returns
+// number of bytes written or 0 if count is out of range
+size_t param_proto_encode(uint8_t *out, const param_update_t *updates, uint8_t count);
+
+#endif
@@ -0,0 +1,188 @@
+#include "pico.h"
+#include "pico/sync.h"
+#include "params.h"
+#include "regions.h"
+#include "trace.h"
+#include "palette.h"
+#include "symmetry.h"
+#include "governor.h"
+#include "life.h"
+#include "particles.h"
+#include "scroll.h"
+#include "modulation.h"
+#include "wall.h"
+#include "wobble.h"
+#include "noise.h"
+
+// Range and power-on value of each parameter
+typedef struct {
+    uint16_t min;
+    uint16_t max;
+    uint16_t initial;
+} param_info_t;
+
+static const param_info_t param_info[PARAM_COUNT] = {
+    [PARAM_DEMO]          = {0, DEMO_COUNT - 1, DEMO_SINE},
+    [PARAM_SPEED_INC]     = {1, 255, 2},
+    [PARAM_SPEED_FRAME]   = {1, 255, 1},
+    [PARAM_BLOCK_SIZE]    = {4, 128, 128},
+    [PARAM_PATTERN_MASK]  = {0, 0x1f, 0},
+    [PARAM_PLASMA_SCALE]  = {1, 32, 4},
+    [PARAM_LAYOUT]        = {0, LAYOUT_COUNT - 1, LAYOUT_FULL},
+    [PARAM_REGION1_DEMO]  = {0, DEMO_COUNT - 1, DEMO_CHECKERBOARD},
+    [PARAM_REGION2_DEMO]  = {0, DEMO_COUNT - 1, DEMO_PLASMA},
+    [PARAM_REGION3_DEMO]  = {0, DEMO_COUNT - 1, DEMO_BOX},
+    [PARAM_OSD]           = {0, 1, 0},
+    [PARAM_TRACE]         = {0, TRACE_MODE_COUNT - 1, TRACE_OFF},
+    [PARAM_PALETTE]       = {0, PALETTE_COUNT - 1, PALETTE_RAINBOW},
+    [PARAM_PALETTE_CYCLE] = {0, 255, 0},
+    [PARAM_SYMMETRY]      = {0, SYMMETRY_COUNT - 1, SYMMETRY_NONE},
+    [PARAM_RESOLUTION]    = {0, RESOLUTION_COUNT - 1, RESOLUTION_AUTO},
+    [PARAM_CA_RULE]       = {0, 255, LIFE_RULE_GAME_OF_LIFE},
+    [PARAM_PARTICLES]     = {0, PARTICLE_POOL, 256},
+    [PARAM_WIREFRAME]     = {0, 1, 0},
+    [PARAM_SCROLL_DX]     = {0, SCROLL_MAX_SPEED, 1},
+    [PARAM_SCROLL_DY]     = {0, SCROLL_MAX_SPEED, 1},
+    [PARAM_MOD]           = {0, MOD_COUNT - 1, MOD_OFF},
+    [PARAM_MOD_DEPTH]     = {0, 200, 100},
+    [PARAM_MOD_RATE]      = {1, 400, 100},
+    [PARAM_SAVE_SCENE]    = {0, 1, 0},
+    [PARAM_WALL_COLUMNS]  = {1, WALL_MAX_SIZE, 1},
+    [PARAM_WALL_ROWS]     = {1, WALL_MAX_SIZE, 1},
+    [PARAM_WALL_TILE]     = {0, WALL_MAX_SIZE * WALL_MAX_SIZE - 1, 0},
+    [PARAM_WOBBLE]        = {0, WOBBLE_COUNT - 1, WOBBLE_OFF},
+    [PARAM_WOBBLE_DEPTH]  = {0, WOBBLE_MAX_DEPTH, 8},
+    [PARAM_NOISE_DENSITY] = {0, NOISE_ALL, NOISE_ALL},
+    [PARAM_NOISE_MIX]     = {0, NOISE_ALL, 0},
+};
+
+const char *const param_names[PARAM_COUNT] = {
+    [PARAM_DEMO]          = "demo",
+    [PARAM_SPEED_INC]     = "speed_inc",
+    [PARAM_SPEED_FRAME]   = "speed_frame",
+    [PARAM_BLOCK_SIZE]    = "block_size",
+    [PARAM_PATTERN_MASK]  = "pattern_mask",
+    [PARAM_PLASMA_SCALE]  = "plasma_scale",
+    [PARAM_LAYOUT]        = "layout",
+    [PARAM_REGION1_DEMO]  = "region1_demo",
+    [PARAM_REGION2_DEMO]  = "region2_demo",
+    [PARAM_REGION3_DEMO]  = "region3_demo",
+    [PARAM_OSD]           = "osd",
+    [PARAM_TRACE]         = "trace",
+    [PARAM_PALETTE]       = "palette",
+    [PARAM_PALETTE_CYCLE] = "palette_cycle",
+    [PARAM_SYMMETRY]      = "symmetry",
+    [PARAM_RESOLUTION]    = "resolution",
+    [PARAM_CA_RULE]       = "ca_rule",
+    [PARAM_PARTICLES]     = "particles",
+    [PARAM_WIREFRAME]     = "wireframe",
+    [PARAM_SCROLL_DX]     = "scroll_dx",
+    [PARAM_SCROLL_DY]     = "scroll_dy",
+    [PARAM_MOD]           = "mod",
+    [PARAM_MOD_DEPTH]     = "mod_depth",
+    [PARAM_MOD_RATE]      = "mod_rate",
+    [PARAM_SAVE_SCENE]    = "save_scene",
+    [PARAM_WALL_COLUMNS]  = "wall_columns",
+    [PARAM_WALL_ROWS]     = "wall_rows",
+    [PARAM_WALL_TILE]     = "wall_tile",
+    [PARAM_WOBBLE]        = "wobble",
+    [PARAM_WOBBLE_DEPTH]  = "wobble_depth",
+    [PARAM_NOISE_DENSITY] = "noise_density",
+    [PARAM_NOISE_MIX]     = "noise_mix",
+};
+
+effect_params_t effect_params;
+
+// Values as last set by the pots and USB, which modulation is added to
+static effect_params_t base;
+static uint32_t modulated_mask;
+
+// Staged values and a bit per parameter that has a pending update
+static effect_params_t staged;
+static uint32_t staged_mask;
+static spin_lock_t *params_lock;
+
+static_assert(PARAM_COUNT <= 32, "staged_mask holds one bit per parameter");
+
+void params_init(void) {
+    params_lock = spin_lock_init(spin_lock_claim_unused(true));
+
+    for(uint id = 0; id < PARAM_COUNT; id++) {
+        effect_params.value[id] = param_info[id].initial;
+    }
+    staged = effect_params;
+    staged_mask = 0;
+    base = effect_params;
+    modulated_mask = 0;
+}
+
+void params_stage(const param_update_t *updates, unsigned int count) {
+    uint32_t save = spin_lock_blocking(params_lock);
+
+    for(uint n = 0; n < count; n++) {
+        uint id = updates[n].id;
+        if(id >= PARAM_COUNT) {
+            continue;
+        }
+        uint16_t value = updates[n].value;
+        if(value < param_info[id].min) {
+            value = param_info[id].min;
+        } else if(value > param_info[id].max) {
+            value = param_info[id].max;
+        }
+        staged.value[id] = value;
+        staged_mask |= 1u << id;
+    }
+
+    spin_unlock(params_lock, save);
+}
+
+uint32_t params_apply_pending(void) {
+    // Cheap unlocked check so idle frames don't touch the lock
+    if(!*(volatile uint32_t *)&staged_mask) {
+        return 0;
+    }
+
+    uint32_t save = spin_lock_blocking(params_lock);
+
+    uint32_t applied = staged_mask;
+    uint32_t mask = applied;
+    for(uint id = 0; mask; id++, mask >>= 1) {
+        if(mask & 1u) {
+            base.value[id] = staged.value[id];
+            effect_params.value[id] = staged.value[id];
+        }
+    }
+    staged_mask = 0;
+
+    spin_unlock(params_lock, save);
+    return applied;
+}
+
+void params_modulate(const int16_t *offsets, uint32_t mask) {
+    uint32_t restore = modulated_mask & ~mask;
+    for(uint id = 0; restore; id++, restore >>= 1) {
+        if(restore & 1u) {
+            effect_params.value[id] = base.value[id];
+        }
+    }
+
+    modulated_mask = mask;
+    for(uint id = 0; mask; id++, mask >>= 1) {
+        if(mask & 1u) {
+            int32_t value = base.value[id] + offsets[id];
+            effect_params.value[id] = MIN(MAX(value, param_info[id].min), param_info[id].max);
+        }
+    }
+}
+
+uint16_t params_base(uint8_t id) {
+    return base.value[id];
+}
+
+void params_snapshot_base(effect_params_t *out) {
+    // Core 1 writes base under the lock in params_apply_pending
+    uint32_t save = spin_lock_blocking(params_lock);
+    *out = base;
+    spin_unlock(params_lock, save);
+}
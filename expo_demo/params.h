@@ -0,0 +1,109 @@
+// Effect parameter block
+//
+// Core 1 reads effect_params while drawing. Updates from the pots or USB are
+// staged by core 0 and copied into effect_params by core 1 at the start of
+// each frame, so a batch of changes always lands on the same frame.
+
+#ifndef PARAMS_H
+#define PARAMS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "param_proto.h"
+
+// Parameter IDs (also used as IDs in the USB control protocol)
+enum {
+    PARAM_DEMO,          // Demo selection (see DEMO_* below)
+    PARAM_SPEED_INC,     // Amount by which offset increases
+    PARAM_SPEED_FRAME,   // Number of frames until offset updates
+    PARAM_BLOCK_SIZE,    // Block size for checkerboard demo
+    PARAM_PATTERN_MASK,  // Color mask for test pattern demo
+    PARAM_PLASMA_SCALE,  // Spatial frequency of plasma and polar demos
+    PARAM_LAYOUT,        // Split-screen layout (see LAYOUT_* in regions.h)
+    PARAM_REGION1_DEMO,  // Demo shown in layout slot 1 (slot 0 uses PARAM_DEMO)
+    PARAM_REGION2_DEMO,  // Demo shown in layout slot 2
+    PARAM_REGION3_DEMO,  // Demo shown in layout slot 3
+    PARAM_OSD,           // On-screen display (0 = off, 1 = on)
+    PARAM_TRACE,         // Pot trace record/replay (see TRACE_* in trace.h)
+    PARAM_PALETTE,       // Palette for indexed demos (see PALETTE_* in palette.h)
+    PARAM_PALETTE_CYCLE, // Palette rotation per frame (values above 128 rotate backwards)
+    PARAM_SYMMETRY,      // Mirror/kaleidoscope mode (see SYMMETRY_* in symmetry.h)
+    PARAM_RESOLUTION,    // Automatic or fixed render resolution (see RESOLUTION_* in governor.h)
+    PARAM_CA_RULE,       // Cellular automaton rule (0 = Life, 1-255 = elementary rule, see life.h)
+    PARAM_PARTICLES,     // Particles in the starfield and sparks demos
+    PARAM_WIREFRAME,     // Solid demos drawn as edges only (0 = filled, 1 = wireframe)
+    PARAM_SCROLL_DX,     // Scrolling background speed to the left, pixels per frame
+    PARAM_SCROLL_DY,     // Scrolling background speed upwards, lines per frame
+    PARAM_MOD,           // Modulation preset (see MOD_* in modulation.h)
+    PARAM_MOD_DEPTH,     // Modulation depth in percent of each route's depth
+    PARAM_MOD_RATE,      // Modulation LFO rate in percent of each route's rate
+    PARAM_SAVE_SCENE,    // Set to 1 to save the parameters as the power-on scene (see persist.h)
+    PARAM_WALL_COLUMNS,  // Video wall width in screens (read at power-on, see wall.h)
+    PARAM_WALL_ROWS,     // Video wall height in screens (read at power-on)
+    PARAM_WALL_TILE,     // This board's screen, left to right then top to bottom (0 leads the frame sync)
+    PARAM_WOBBLE,        // Per-line horizontal displacement (see WOBBLE_* in wobble.h)
+    PARAM_WOBBLE_DEPTH,  // Displacement in pixels (see WOBBLE_MAX_DEPTH)
+    PARAM_NOISE_DENSITY, // Lit cells of the noise demo and mix layer in 256ths (see noise.h)
+    PARAM_NOISE_MIX,     // Rows of cells of every demo replaced by noise, in 256ths
+    PARAM_COUNT
+};
+
+// Values of PARAM_DEMO
+enum {
+    DEMO_SINE,
+    DEMO_CHECKERBOARD,
+    DEMO_BOX,
+    DEMO_PATTERN,
+    DEMO_PLASMA,
+    DEMO_INTERFERENCE,
+    DEMO_MOIRE,
+    DEMO_TUNNEL,
+    DEMO_RINGS,
+    DEMO_SPIRAL,
+    DEMO_LIFE,
+    DEMO_STARFIELD,
+    DEMO_SPARKS,
+    DEMO_CUBE,
+    DEMO_TORUS,
+    DEMO_SCROLL,
+    DEMO_COPPER,
+    DEMO_NOISE,
+    DEMO_COUNT
+};
+
+typedef struct {
+    uint16_t value[PARAM_COUNT];
+} effect_params_t;
+
+// Short name of each parameter (used by host tools)
+extern const char *const param_names[PARAM_COUNT];
+
+// Live parameters (with modulation applied), only written by core 1 between frames
+extern effect_params_t effect_params;
+
+// Shorthand for reading a live parameter
+#define param(id) (effect_params.value[(id)])
+
+void params_init(void);
+
+// Queue a batch of updates to be applied at the next frame (any core)
+// Unknown IDs are ignored and values are clamped to the parameter's range
+void params_stage(const param_update_t *updates, unsigned int count);
+
+// Apply staged updates to effect_params (core 1, at frame boundary)
+// Returns a bit per parameter updated (0 if none)
+uint32_t params_apply_pending(void);
+
+// Set the parameters in mask to their staged values plus offsets (clamped to
+// their range), and return any modulated last frame but not in mask to their
+// staged values (core 1, at frame boundary after params_apply_pending)
+void params_modulate(const int16_t *offsets, uint32_t mask);
+
+// Value of a parameter as last set by the pots and USB, without modulation (core 1)
+uint16_t params_base(uint8_t id);
+
+// Copy every parameter as last set by the pots and USB, without modulation, as
+// one consistent set (any core)
+void params_snapshot_base(effect_params_t *out);
+
+#endif
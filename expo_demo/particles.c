@@ -0,0 +1,299 @@
+#include "particles.h"
+#include "span.h"
+#include "params.h"
+#include "palette.h"
+#include "regions.h"
+#include "video_mode.h"
+#include "wall.h"
+#include "handoff.h"
+#include "rng.h"
+#include "placement.h"
+#include <math.h>
+#include <string.h>
+
+// Starfield: stars start anywhere in a box STAR_RANGE either side of the
+// middle at depth STAR_FAR and fly towards the screen at depth 0
+#define STAR_RANGE 4096
+#define STAR_FAR 4096
+// Depth moved per frame for each step of PARAM_SPEED_INC
+#define STAR_SPEED 4
+
+// Sparks: frames before a spark goes out
+#define SPARK_LIFE 200
+
+typedef struct {
+    // Starfield: position in the box; sparks: screen position in 1/256 pixels
+    int32_t x, y;
+    // Sparks: velocity in 1/256 pixels per frame
+    int16_t vx, vy;
+    // Starfield: depth
+    uint16_t z;
+    // Sparks: frames since launch
+    uint8_t age;
+    bool alive;
+} particle_t;
+
+// A particle on a line: its pixel and shade (a palette index for sparks, a
+// brightness 0-31 for stars)
+typedef struct {
+    uint16_t x;
+    uint8_t shade;
+} dot_t;
+
+// Dots sorted by line then x, line y's dots are dots[line_start[y]] up to dots[line_start[y + 1]]
+typedef struct {
+    uint16_t line_start[PARTICLE_MAX_LINES + 1];
+    dot_t dots[PARTICLE_POOL];
+} bucket_t;
+
+typedef struct {
+    particle_t pool[PARTICLE_POOL];
+    bucket_t buckets[2];
+    // Buckets core 1 is drawing and the ones core 0 fills
+    handoff_t handoff;
+} particle_system_t;
+
+static particle_system_t systems[PARTICLES_SYSTEM_COUNT];
+
+// Demo showing each system
+static const uint8_t system_demos[PARTICLES_SYSTEM_COUNT] = {
+    [PARTICLES_STARFIELD] = DEMO_STARFIELD,
+    [PARTICLES_SPARKS]    = DEMO_SPARKS,
+};
+
+static uint16_t star_colors[32];
+// Middle of the canvas, and lines of this screen
+static uint16_t center_x, center_y, lines;
+static int16_t spark_gravity, spark_speed;
+
+// Core 0 scratch: particles on screen this step, in pool order
+typedef struct {
+    uint16_t x, y;
+    uint8_t shade;
+} visible_t;
+
+static visible_t visible[PARTICLE_POOL];
+static uint16_t visible_count;
+static uint16_t line_cursor[PARTICLE_MAX_LINES];
+
+static uint32_t rng = 0x9e3779b9;
+
+// Random value 0 to n - 1
+static inline int32_t random_below(uint32_t n) {
+    return (int32_t)(((uint64_t)rng_next(&rng) * n) >> 32);
+}
+
+static void spawn_star(particle_t *s, bool scatter) {
+    // Stars outside the view at the far end would never come into it, so
+    // the box is as wide as the view there and the screen's shape
+    s->x = random_below(2 * STAR_RANGE) - STAR_RANGE;
+    s->y = random_below(2 * STAR_RANGE * center_y / center_x) - STAR_RANGE * center_y / center_x;
+    s->z = scatter ? 1 + random_below(STAR_FAR) : STAR_FAR;
+    s->alive = true;
+}
+
+static void spawn_spark(particle_t *s) {
+    // Launched from the bottom middle, mostly upwards
+    s->x = (center_x + random_below(9) - 4) << 8;
+    s->y = (wall_height - 1) << 8;
+    s->vx = random_below(spark_speed / 2) - spark_speed / 4;
+    s->vy = -(spark_speed * (192 + random_below(64)) >> 8);
+    s->age = 0;
+    s->alive = true;
+}
+
+// Whether a point on the canvas is on this screen
+static inline bool on_screen(int32_t x, int32_t y) {
+    return x >= wall_x0 && x < wall_x0 + vga_mode.width && y >= wall_y0 && y < wall_y0 + lines;
+}
+
+static void step_stars(particle_t *pool, uint16_t count) {
+    uint16_t speed = param(PARAM_SPEED_INC) * STAR_SPEED;
+    for(uint n = 0; n < count; n++) {
+        particle_t *s = &pool[n];
+        if(!s->alive) {
+            spawn_star(s, true);
+        } else if(s->z <= speed) {
+            spawn_star(s, false);
+        } else {
+            s->z -= speed;
+        }
+
+        // Perspective divide (one per star per frame)
+        int32_t sx = center_x + s->x * center_x / s->z;
+        int32_t sy = center_y + s->y * center_x / s->z;
+        if(sx < 0 || sx >= wall_width || sy < 0 || sy >= wall_height) {
+            // Flown past the edge, replaced next frame
+            s->alive = false;
+            continue;
+        }
+        if(!on_screen(sx, sy)) {
+            continue;
+        }
+        uint8_t shade = 31 - s->z * 24 / STAR_FAR;
+        visible[visible_count++] = (visible_t){sx, sy - wall_y0, shade};
+    }
+}
+
+static void step_sparks(particle_t *pool, uint16_t count) {
+    // Launch a few sparks a frame so they spread out into a stream
+    uint16_t launches = MAX(count / 64, 1);
+    for(uint n = 0; n < count; n++) {
+        particle_t *s = &pool[n];
+        if(!s->alive) {
+            if(!launches) {
+                continue;
+            }
+            launches--;
+            spawn_spark(s);
+        } else {
+            s->vy += spark_gravity;
+            s->x += s->vx;
+            s->y += s->vy;
+            s->age++;
+        }
+
+        int32_t sx = s->x >> 8;
+        int32_t sy = s->y >> 8;
+        if(s->age == SPARK_LIFE || sx < 0 || sx >= wall_width || sy >= wall_height) {
+            s->alive = false;
+            continue;
+        }
+        // Still rising above the top of the canvas, or on another screen of the wall
+        if(sy < 0 || !on_screen(sx, sy)) {
+            continue;
+        }
+        visible[visible_count++] = (visible_t){sx, sy - wall_y0, s->age};
+    }
+}
+
+// Counting sort of the visible particles into buckets by line, then by x
+// within each line (lines hold few particles, so insertion sort)
+static void fill_buckets(bucket_t *b) {
+    uint16_t *start = b->line_start;
+    memset(start, 0, (lines + 1) * sizeof(start[0]));
+    for(uint n = 0; n < visible_count; n++) {
+        start[visible[n].y + 1]++;
+    }
+    for(uint y = 0; y < lines; y++) {
+        start[y + 1] += start[y];
+        line_cursor[y] = start[y];
+    }
+
+    for(uint n = 0; n < visible_count; n++) {
+        const visible_t *v = &visible[n];
+        b->dots[line_cursor[v->y]++] = (dot_t){v->x, v->shade};
+    }
+
+    for(uint y = 0; y < lines; y++) {
+        dot_t *dots = &b->dots[start[y]];
+        uint16_t count = start[y + 1] - start[y];
+        for(uint i = 1; i < count; i++) {
+            dot_t dot = dots[i];
+            uint j = i;
+            for(; j > 0 && dots[j - 1].x > dot.x; j--) {
+                dots[j] = dots[j - 1];
+            }
+            dots[j] = dot;
+        }
+    }
+}
+
+void particles_init(void) {
+    center_x = wall_width / 2;
+    center_y = wall_height / 2;
+    lines = MIN(vga_mode.height, PARTICLE_MAX_LINES);
+
+    // Gravity scaled to the canvas so sparks reach about 3/4 of the way up
+    spark_gravity = MAX(wall_height / 10, 1);
+    spark_speed = (int16_t)sqrtf(2.0f * spark_gravity * (wall_height * 3 / 4) * 256);
+
+    for(uint v = 0; v < count_of(star_colors); v++) {
+        star_colors[v] = PICO_SCANVIDEO_PIXEL_FROM_RGB5(v, v, v);
+    }
+
+    for(uint s = 0; s < PARTICLES_SYSTEM_COUNT; s++) {
+        handoff_init(&systems[s].handoff);
+    }
+    for(uint n = 0; n < PARTICLE_POOL; n++) {
+        spawn_star(&systems[PARTICLES_STARFIELD].pool[n], true);
+    }
+}
+
+void particles_step(uint8_t system, uint16_t count, uint steps) {
+    particle_system_t *sys = &systems[system];
+    count = MIN(count, PARTICLE_POOL);
+
+    // Only the last step's visible particles are drawn
+    for(uint n = 0; n < steps; n++) {
+        visible_count = 0;
+        if(system == PARTICLES_STARFIELD) {
+            step_stars(sys->pool, count);
+        } else {
+            step_sparks(sys->pool, count);
+        }
+    }
+
+    fill_buckets(&sys->buckets[handoff_back(&sys->handoff)]);
+    handoff_publish(&sys->handoff);
+}
+
+void particles_poll(void) {
+    // Step once for each frame since the last step, and only while the system
+    // is on screen
+    for(uint s = 0; s < PARTICLES_SYSTEM_COUNT; s++) {
+        uint steps;
+        if(!regions_show_demo(system_demos[s]) || !(steps = handoff_begin_step(&systems[s].handoff))) {
+            continue;
+        }
+        particles_step(s, param(PARAM_PARTICLES), steps);
+    }
+}
+
+void particles_begin_frame(void) {
+    for(uint s = 0; s < PARTICLES_SYSTEM_COUNT; s++) {
+        handoff_take(&systems[s].handoff);
+    }
+}
+
+uint16_t *__render_func(particles_span)(uint8_t system, uint16_t *p, uint16_t y, uint16_t x0, uint16_t x1) {
+    uint16_t line = y - wall_y0;
+    if(line >= lines) {
+        return span_color(p, 0, x1 - x0);
+    }
+
+    const particle_system_t *sys = &systems[system];
+    const bucket_t *b = &sys->buckets[sys->handoff.front];
+    const dot_t *dot = &b->dots[b->line_start[line]];
+    const dot_t *end = &b->dots[b->line_start[line + 1]];
+
+    // Dots are sorted by x, skip the ones left of the span
+    while(dot < end && dot->x < x0) {
+        dot++;
+    }
+
+    uint16_t x = x0;
+    for(uint drawn = 0; dot < end && dot->x < x1 && drawn < PARTICLE_LINE_MAX; dot++) {
+        // Several particles on one pixel draw once
+        if(dot->x < x) {
+            continue;
+        }
+        uint16_t color = (system == PARTICLES_STARFIELD) ? star_colors[dot->shade] : palette[dot->shade];
+        p = span_color(p, 0, dot->x - x);
+        p = span_color(p, color, 1);
+        x = dot->x + 1;
+        drawn++;
+    }
+
+    return span_color(p, 0, x1 - x);
+}
+
+uint16_t particles_line_count(uint8_t system, uint16_t y) {
+    uint16_t line = y - wall_y0;
+    if(line >= lines) {
+        return 0;
+    }
+    const particle_system_t *sys = &systems[system];
+    const bucket_t *b = &sys->buckets[sys->handoff.front];
+    return b->line_start[line + 1] - b->line_start[line];
+}
@@ -0,0 +1,50 @@
+// Particle effects (starfield and sparks)
+//
+// Each system has a fixed pool of particles. Core 0 moves them once per frame
+// in fixed point and sorts the ones on screen into a bucket per line (a
+// counting sort by y, then by x within each line) in a back buffer. Core 1
+// picks up the newest buckets at the frame boundary, so a line only costs the
+// particles that land on it.
+
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+#include "pico.h"
+
+// Particles per system (the most PARAM_PARTICLES can ask for)
+#define PARTICLE_POOL 1024
+
+// Most particles drawn on one line, which keeps a busy line within the
+// scanline buffer (the rest of the line's particles are skipped)
+#define PARTICLE_LINE_MAX 32
+
+// Lines covered by the buckets (taller modes leave the bottom empty)
+#define PARTICLE_MAX_LINES 480
+
+enum {
+    PARTICLES_STARFIELD, // Stars flying out from the middle, brighter as they near
+    PARTICLES_SPARKS,    // Fountain of sparks falling under gravity, colored by age
+    PARTICLES_SYSTEM_COUNT
+};
+
+// Scatter the starfield (call once before drawing)
+void particles_init(void);
+
+// Step each system that is on screen if core 1 has picked up its last frame
+// (core 0, call often)
+void particles_poll(void);
+
+// Move the first count particles of a system steps frames on and publish them
+// to core 1 (core 0, once core 1 has picked up the last step)
+void particles_step(uint8_t system, uint16_t count, uint steps);
+
+// Switch to the newest buckets (core 1, at frame boundary)
+void particles_begin_frame(void);
+
+// Write pixels x0 to x1 (exclusive) of line y of a system
+uint16_t *particles_span(uint8_t system, uint16_t *p, uint16_t y, uint16_t x0, uint16_t x1);
+
+// Particles in line y's bucket, including any over PARTICLE_LINE_MAX (core 1)
+uint16_t particles_line_count(uint8_t system, uint16_t y);
+
+#endif
@@ -0,0 +1,230 @@
+#include "persist.h"
+#include "params.h"
+#include "video_mode.h"
+#include "build_id.h"
+#include "hardware/flash.h"
+#include "pico/flash.h"
+#include <string.h>
+
+// Areas counted back from the end of flash: the calibration table has the
+// last sector (see calibrate.c), the scene the one before, and the tables the
+// TABLE_SECTORS before that
+#define SCENE_OFFSET (PICO_FLASH_SIZE_BYTES - 2 * FLASH_SECTOR_SIZE)
+#define TABLE_SECTORS 12
+#define TABLES_OFFSET (SCENE_OFFSET - TABLE_SECTORS * FLASH_SECTOR_SIZE)
+
+#define SCENE_MAGIC 0x4e435345 // "ESCN"
+#define TABLES_MAGIC 0x4c425445 // "ETBL"
+
+// Bump when the meaning of saved parameter values changes
+#define SCENE_VERSION 1
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    // Parameters saved (the first count of values)
+    uint16_t count;
+    uint32_t hash;
+    uint16_t values[PARAM_COUNT];
+} scene_t;
+
+// The table area starts with this header in its first page, then each table
+// from the next page boundary in id order
+typedef struct {
+    uint32_t magic;
+    uint32_t stamp;
+    struct {
+        uint32_t size;
+        uint32_t hash;
+    } tables[PERSIST_TABLE_COUNT];
+    uint32_t hash;
+} table_header_t;
+
+static_assert(sizeof(scene_t) <= FLASH_PAGE_SIZE, "scene is programmed as one page");
+static_assert(sizeof(table_header_t) <= FLASH_PAGE_SIZE, "table header is programmed as one page");
+
+// Tables registered by persist_table
+static struct {
+    void *data;
+    uint32_t size;
+} tables[PERSIST_TABLE_COUNT];
+static bool tables_checked, tables_valid, tables_built;
+
+static bool scene_restored;
+static bool scene_saved;
+
+#define HASH_START 2166136261u
+
+// FNV-1a
+static uint32_t hash_bytes(uint32_t hash, const void *data, uint32_t size) {
+    const uint8_t *p = data;
+    for(uint32_t n = 0; n < size; n++) {
+        hash = (hash ^ p[n]) * 16777619u;
+    }
+    return hash;
+}
+
+static uint32_t page_round(uint32_t size) {
+    return (size + FLASH_PAGE_SIZE - 1) & ~(FLASH_PAGE_SIZE - 1);
+}
+
+uint32_t persist_build_stamp(void) {
+    static const uint32_t build = BUILD_ID;
+    uint32_t hash = hash_bytes(HASH_START, &build, sizeof(build));
+    hash = (hash ^ vga_mode.width) * 16777619u;
+    return (hash ^ vga_mode.height) * 16777619u;
+}
+
+static const scene_t *saved_scene(void) {
+    return (const scene_t *)(XIP_BASE + SCENE_OFFSET);
+}
+
+bool persist_load_scene(void) {
+    const scene_t *scene = saved_scene();
+    if(scene->magic != SCENE_MAGIC || scene->version != SCENE_VERSION || scene->count > PARAM_COUNT ||
+       scene->hash != hash_bytes(HASH_START, scene->values, scene->count * sizeof(uint16_t))) {
+        return false;
+    }
+
+    // Trace mode and the save request itself are not part of a scene
+    param_update_t updates[PARAM_COUNT];
+    uint count = 0;
+    for(uint id = 0; id < scene->count; id++) {
+        if(id != PARAM_TRACE && id != PARAM_SAVE_SCENE) {
+            updates[count++] = (param_update_t){id, scene->values[id]};
+        }
+    }
+    params_stage(updates, count);
+    params_apply_pending();
+    scene_restored = true;
+    return true;
+}
+
+bool persist_scene_restored(void) {
+    return scene_restored;
+}
+
+static const table_header_t *saved_tables(void) {
+    return (const table_header_t *)(XIP_BASE + TABLES_OFFSET);
+}
+
+static const uint8_t *saved_table(uint8_t id) {
+    const table_header_t *header = saved_tables();
+    uint32_t offset = TABLES_OFFSET + FLASH_PAGE_SIZE;
+    for(uint n = 0; n < id; n++) {
+        offset += page_round(header->tables[n].size);
+    }
+    return (const uint8_t *)(uintptr_t)(XIP_BASE + offset);
+}
+
+static void check_tables(void) {
+    const table_header_t *header = saved_tables();
+    tables_checked = true;
+    tables_valid = header->magic == TABLES_MAGIC && header->stamp == persist_build_stamp() &&
+                   header->hash == hash_bytes(HASH_START, header, offsetof(table_header_t, hash));
+}
+
+bool persist_table(uint8_t id, void *data, uint32_t size) {
+    if(!tables_checked) {
+        check_tables();
+    }
+    tables[id].data = data;
+    tables[id].size = size;
+
+    const table_header_t *header = saved_tables();
+    if(tables_valid && header->tables[id].size == size) {
+        const uint8_t *saved = saved_table(id);
+        if(header->tables[id].hash == hash_bytes(HASH_START, saved, size)) {
+            memcpy(data, saved, size);
+            return true;
+        }
+    }
+    tables_built = true;
+    return false;
+}
+
+// Program size bytes from data at offset, padding the last page
+static void program(uint32_t offset, const void *data, uint32_t size) {
+    static uint8_t page[FLASH_PAGE_SIZE];
+    uint32_t whole = size & ~(FLASH_PAGE_SIZE - 1);
+    if(whole) {
+        flash_range_program(offset, data, whole);
+    }
+    if(size > whole) {
+        memset(page, 0xff, sizeof(page));
+        memcpy(page, (const uint8_t *)data + whole, size - whole);
+        flash_range_program(offset + whole, page, FLASH_PAGE_SIZE);
+    }
+}
+
+static void write_tables(void *param) {
+    const table_header_t *header = param;
+    uint32_t total = FLASH_PAGE_SIZE;
+    for(uint id = 0; id < PERSIST_TABLE_COUNT; id++) {
+        total += page_round(tables[id].size);
+    }
+    flash_range_erase(TABLES_OFFSET, (total + FLASH_SECTOR_SIZE - 1) & ~(FLASH_SECTOR_SIZE - 1));
+
+    program(TABLES_OFFSET, header, sizeof(*header));
+    uint32_t offset = TABLES_OFFSET + FLASH_PAGE_SIZE;
+    for(uint id = 0; id < PERSIST_TABLE_COUNT; id++) {
+        program(offset, tables[id].data, tables[id].size);
+        offset += page_round(tables[id].size);
+    }
+}
+
+void persist_save_tables(void) {
+    if(!tables_built) {
+        return;
+    }
+
+    static table_header_t header;
+    uint32_t total = FLASH_PAGE_SIZE;
+    header.magic = TABLES_MAGIC;
+    header.stamp = persist_build_stamp();
+    for(uint id = 0; id < PERSIST_TABLE_COUNT; id++) {
+        header.tables[id].size = tables[id].size;
+        header.tables[id].hash = hash_bytes(HASH_START, tables[id].data, tables[id].size);
+        total += page_round(tables[id].size);
+    }
+    header.hash = hash_bytes(HASH_START, &header, offsetof(table_header_t, hash));
+
+    // Tables that outgrow the area are built at every boot instead
+    if(total > TABLE_SECTORS * FLASH_SECTOR_SIZE) {
+        return;
+    }
+    flash_safe_execute(write_tables, &header, UINT32_MAX);
+    tables_built = false;
+}
+
+static void write_scene(void *param) {
+    flash_range_erase(SCENE_OFFSET, FLASH_SECTOR_SIZE);
+    program(SCENE_OFFSET, param, sizeof(scene_t));
+}
+
+void persist_poll(void) {
+    // Save once each time the parameter is set
+    if(!param(PARAM_SAVE_SCENE)) {
+        scene_saved = false;
+        return;
+    }
+    if(scene_saved) {
+        return;
+    }
+    scene_saved = true;
+
+    static scene_t scene;
+    scene.magic = SCENE_MAGIC;
+    scene.version = SCENE_VERSION;
+    scene.count = PARAM_COUNT;
+    effect_params_t values;
+    params_snapshot_base(&values);
+    for(uint id = 0; id < PARAM_COUNT; id++) {
+        scene.values[id] = values.value[id];
+    }
+    scene.hash = hash_bytes(HASH_START, scene.values, sizeof(scene.values));
+    flash_safe_execute(write_scene, &scene, UINT32_MAX);
+
+    param_update_t clear = {PARAM_SAVE_SCENE, 0};
+    params_stage(&clear, 1);
+}
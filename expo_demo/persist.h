@@ -0,0 +1,62 @@
+// Flash persistence of the scene and of generated tables
+//
+// Two areas sit below the calibration table at the end of flash:
+//
+// - The scene sector holds the parameters saved with PARAM_SAVE_SCENE, which
+//   are restored at power-up instead of the defaults. Scenes carry a format
+//   version and the number of parameters they were saved with, so a build
+//   that appends parameters still loads an older scene.
+// - The table area holds the lookup tables the effects build at start-up
+//   (gradients, sine tables, polar maps, meshes), stamped with the build and
+//   video mode. The first boot of a build computes them and saves them, and
+//   later boots copy them from flash, which takes a fraction of the time of
+//   the floating point work, so video starts sooner after a power glitch.
+//
+// Every block is checked with a hash before it is used; anything that does
+// not match is ignored and rebuilt.
+
+#ifndef PERSIST_H
+#define PERSIST_H
+
+#include "pico.h"
+
+// Tables kept in flash
+enum {
+    PERSIST_TABLE_GRADIENTS,
+    PERSIST_TABLE_PLASMA_SINE,
+    PERSIST_TABLE_POLAR_ANGLE,
+    PERSIST_TABLE_POLAR_RADIUS,
+    PERSIST_TABLE_POLAR_DEPTH,
+    PERSIST_TABLE_SINE,
+    PERSIST_TABLE_SOLID_MESHES,
+    PERSIST_TABLE_COPPER_COLORS,
+    PERSIST_TABLE_COUNT
+};
+
+// Hash identifying this firmware build (from the sources and settings it was
+// built from, see build_id.cmake) and video mode
+uint32_t persist_build_stamp(void);
+
+// Stage the saved scene, if there is a valid one, and apply it (core 0, after
+// params_init and before anything reads the parameters). Returns true if a
+// scene was restored
+bool persist_load_scene(void);
+
+// Whether persist_load_scene restored a scene
+bool persist_scene_restored(void);
+
+// Copy table id from flash into data and return true, or return false and
+// note the table for persist_save_tables once the caller has built it
+// (during start-up, from the effects' init functions)
+bool persist_table(uint8_t id, void *data, uint32_t size);
+
+// Save every table that had to be built, if any did (core 0, after all the
+// init functions and before core 1 starts)
+void persist_save_tables(void);
+
+// Save the scene when PARAM_SAVE_SCENE is set, then clear it (core 0, call
+// often). The other core is paused while the sector is written, so the
+// picture drops out for a few frames
+void persist_poll(void);
+
+#endif
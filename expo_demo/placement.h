@@ -0,0 +1,37 @@
+// Memory placement of the scanline render path
+//
+// By default code runs from flash through the 16 KiB XIP cache, so how long a
+// line takes depends on what core 0 and earlier lines left in the cache, and a
+// miss stalls core 1 while the flash is read. With RENDER_IN_SRAM (on by
+// default, see CMakeLists.txt):
+//
+// - Every function core 1 calls for each line is marked __render_func and
+//   copied to main SRAM at boot. Main SRAM is striped word by word across four
+//   banks, so core 0, core 1 and the scanvideo DMA reading the scanline
+//   buffers (also in main SRAM) seldom wait on the same bank.
+// - The small tables read for every pixel (the live palette and the sine and
+//   depth tables) are marked __render_table and kept in scratch X, the bank
+//   that only core 1 uses (for its stack), so those loads never wait at all.
+//   The larger polar maps stay in main SRAM with the rest of the data.
+//
+// Per-frame and start-up code stays in flash. The OSD shows the XIP cache hit
+// rate, which with the render path in SRAM is down to core 0 alone.
+
+#ifndef PLACEMENT_H
+#define PLACEMENT_H
+
+#include "pico.h"
+
+#ifndef RENDER_IN_SRAM
+#define RENDER_IN_SRAM 0
+#endif
+
+#if RENDER_IN_SRAM
+#define __render_func(func_name) __not_in_flash_func(func_name)
+#define __render_table __scratch_x("render_tables")
+#else
+#define __render_func(func_name) func_name
+#define __render_table
+#endif
+
+#endif
@@ -0,0 +1,155 @@
+#include "plasma.h"
+#include "span.h"
+#include "palette.h"
+#include "persist.h"
+#include "placement.h"
+#include <math.h>
+
+// One full sine cycle in 256 steps, scaled to 0..63 so four terms fit in 8 bits
+static uint8_t __render_table sine_lut[256];
+
+void plasma_init(void) {
+    if(persist_table(PERSIST_TABLE_PLASMA_SINE, sine_lut, sizeof(sine_lut))) {
+        return;
+    }
+    for(int n = 0; n < 256; n++) {
+        float angle = n * 2 * (float)M_PI / 256;
+        sine_lut[n] = (uint8_t)(31.5f + 31.5f * sinf(angle));
+    }
+}
+
+// Color of one pixel from the sum of two sine phases, then advance both phases
+static inline uint16_t sum_pixel(uint16_t *a, uint16_t da, uint16_t *c, uint16_t dc, uint8_t base, uint8_t shift) {
+    uint8_t v = ((sine_lut[*a >> 8] + sine_lut[*c >> 8]) << shift) + base;
+    *a += da;
+    *c += dc;
+    return palette[v];
+}
+
+// Color of one pixel from two XORed phases, then advance both phases
+static inline uint16_t xor_pixel(uint16_t *a, uint16_t da, uint16_t *c, uint16_t dc, uint8_t base) {
+    uint8_t v = ((*a ^ *c) >> 8) + base;
+    *a += da;
+    *c += dc;
+    return palette[v];
+}
+
+// Either of the above for the given variant
+static inline uint16_t next_pixel(uint8_t variant, uint16_t *a, uint16_t da, uint16_t *c, uint16_t dc, uint8_t base) {
+    if(variant == PLASMA_MOIRE) {
+        return xor_pixel(a, da, c, dc, base);
+    }
+    return sum_pixel(a, da, c, dc, base, (variant == PLASMA_INTERFERENCE) ? 1 : 0);
+}
+
+// Write n pixels from q, two per word store once q is aligned (variant is a
+// constant at each call, so every variant gets its own loop)
+static __force_inline uint16_t *write_pixels(uint16_t *q, uint16_t n, uint8_t variant, uint16_t a, uint16_t da,
+                                             uint16_t c, uint16_t dc, uint8_t base) {
+    if(!span_aligned(q)) {
+        *q++ = next_pixel(variant, &a, da, &c, dc, base);
+        n--;
+    }
+    for(; n >= 2; n -= 2) {
+        uint16_t left = next_pixel(variant, &a, da, &c, dc, base);
+        uint16_t right = next_pixel(variant, &a, da, &c, dc, base);
+        q = span_word(q, left, right);
+    }
+    if(n) {
+        *q++ = next_pixel(variant, &a, da, &c, dc, base);
+    }
+    return q;
+}
+
+// Write pixels x0 to x1 from q with one sample (phases stepping da and dc) for
+// each pair of pixels. Pairs start at even x so neighbouring spans line up
+static uint16_t *__render_func(write_half)(uint16_t *q, uint16_t x0, uint16_t x1, uint8_t variant, uint16_t a,
+                                           uint16_t da, uint16_t c, uint16_t dc, uint8_t base) {
+    uint16_t color = next_pixel(variant, &a, da, &c, dc, base);
+    uint16_t x = x0;
+    if(!span_aligned(q)) {
+        *q++ = color;
+        x++;
+    }
+
+    // Each word holds either one pair, or the end of one pair and the start of the next
+    for(; x + 1 < x1; x += 2) {
+        if(x & 1) {
+            uint16_t left = color;
+            color = next_pixel(variant, &a, da, &c, dc, base);
+            q = span_word(q, left, color);
+        } else {
+            if(x != x0) {
+                color = next_pixel(variant, &a, da, &c, dc, base);
+            }
+            q = span_word(q, color, color);
+        }
+    }
+
+    // Last pixel on its own
+    if(x < x1) {
+        if(!(x & 1) && x != x0) {
+            color = next_pixel(variant, &a, da, &c, dc, base);
+        }
+        *q++ = color;
+    }
+    return q;
+}
+
+uint16_t *__render_func(plasma_span)(uint16_t *p, uint8_t variant, uint16_t y, uint16_t x0, uint16_t x1, uint16_t t,
+                                     uint8_t scale, bool half) {
+    if(x1 <= x0) {
+        return p;
+    }
+
+    // Per-pixel phase step (8.8 fixed point, half a table step per pixel at scale 1)
+    uint16_t kx = scale << 7;
+
+    // Phases at x = 0, per-pixel deltas and a constant added to every pixel on this line
+    // (the only multiplies are here, once per span)
+    uint16_t a, da, c, dc;
+    uint8_t base;
+    switch(variant) {
+        case PLASMA_INTERFERENCE:
+            a = y * (kx >> 1) + (t << 9);
+            da = kx;
+            c = y * (kx - (kx >> 2)) - (t << 9);
+            dc = -(kx - (kx >> 2));
+            base = t;
+            break;
+        case PLASMA_MOIRE:
+            a = y * (kx << 1) + (t << 7);
+            da = kx << 2;
+            c = -(y * (kx << 1)) - (t << 7);
+            dc = (kx << 2) + (kx >> 3);
+            base = t >> 1;
+            break;
+        default: // PLASMA_CLASSIC
+            a = t << 9;
+            da = kx;
+            c = y * kx + (t << 8);
+            dc = kx >> 1;
+            base = sine_lut[(uint8_t)(((y * kx) >> 8) - (t << 1))] + t;
+            break;
+    }
+
+    // Skip ahead to the start of the span (or the start of its first pixel pair)
+    uint16_t start = half ? (x0 & ~1u) : x0;
+    a += start * da;
+    c += start * dc;
+
+    uint16_t len = x1 - x0;
+    uint16_t *q = span_raw_stream(p, len);
+
+    if(half) {
+        q = write_half(q, x0, x1, variant, a, da << 1, c, dc << 1, base);
+    } else if(variant == PLASMA_MOIRE) {
+        q = write_pixels(q, len, PLASMA_MOIRE, a, da, c, dc, base);
+    } else if(variant == PLASMA_INTERFERENCE) {
+        q = write_pixels(q, len, PLASMA_INTERFERENCE, a, da, c, dc, base);
+    } else {
+        q = write_pixels(q, len, PLASMA_CLASSIC, a, da, c, dc, base);
+    }
+
+    return span_raw_end(p, len);
+}
@@ -0,0 +1,28 @@
+// Plasma, interference and moire effects
+//
+// Each pixel is a sum of sines looked up from a table. Phases are 8.8 fixed
+// point and advance by a constant delta per pixel, so the inner loop is only
+// adds, shifts and table loads (no multiply or trig per pixel). The 8-bit
+// plasma value indexes the live palette (see palette.h).
+
+#ifndef PLASMA_H
+#define PLASMA_H
+
+#include "pico.h"
+
+enum {
+    PLASMA_CLASSIC,      // Three sine waves plus a per-line term
+    PLASMA_INTERFERENCE, // Two crossing sine gratings
+    PLASMA_MOIRE         // Two fine gratings of slightly different pitch XORed together
+};
+
+// Build the sine table (call once before drawing)
+void plasma_init(void);
+
+// Write pixels x0 to x1 (exclusive) of line y of a plasma effect at time t
+// scale sets the spatial frequency (1 = broad, larger = finer)
+// half computes one pixel in two and doubles it (half horizontal resolution)
+uint16_t *plasma_span(uint16_t *p, uint8_t variant, uint16_t y, uint16_t x0, uint16_t x1, uint16_t t, uint8_t scale,
+                      bool half);
+
+#endif
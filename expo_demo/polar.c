@@ -0,0 +1,130 @@
+#include "polar.h"
+#include "span.h"
+#include "palette.h"
+#include "wall.h"
+#include "persist.h"
+#include "placement.h"
+#include <math.h>
+
+// Map size for one quadrant (a quadrant of a 320x240 mode at one cell per
+// pixel, larger modes use one cell per 2x2, 4x4... pixels)
+#define MAP_WIDTH 160
+#define MAP_HEIGHT 120
+
+// Angle of each cell from the middle of the screen, 0 to 63 for a quarter turn
+static uint8_t angle_map[MAP_HEIGHT][MAP_WIDTH];
+// Distance of each cell from the middle of the screen in cells
+static uint8_t radius_map[MAP_HEIGHT][MAP_WIDTH];
+// Distance into the tunnel for each radius
+static uint8_t __render_table depth_lut[256];
+
+static uint8_t map_shift;
+static uint16_t center_x, center_y;
+
+void polar_init(void) {
+    center_x = wall_width / 2;
+    center_y = wall_height / 2;
+    map_shift = 0;
+    while((center_x >> map_shift) > MAP_WIDTH || (center_y >> map_shift) > MAP_HEIGHT) {
+        map_shift++;
+    }
+
+    bool angles = persist_table(PERSIST_TABLE_POLAR_ANGLE, angle_map, sizeof(angle_map));
+    bool radii = persist_table(PERSIST_TABLE_POLAR_RADIUS, radius_map, sizeof(radius_map));
+    bool depths = persist_table(PERSIST_TABLE_POLAR_DEPTH, depth_lut, sizeof(depth_lut));
+    if(angles && radii && depths) {
+        return;
+    }
+
+    for(int v = 0; v < MAP_HEIGHT; v++) {
+        for(int u = 0; u < MAP_WIDTH; u++) {
+            // Measured to the middle of the cell, so the quadrants meet without a seam
+            float fx = u + 0.5f;
+            float fy = v + 0.5f;
+            angle_map[v][u] = (uint8_t)(atan2f(fy, fx) * 128 / (float)M_PI);
+            float r = sqrtf(fx * fx + fy * fy);
+            radius_map[v][u] = (r > 255) ? 255 : (uint8_t)r;
+        }
+    }
+
+    // Depth falls off as 1/r, so the walls appear to recede towards the middle
+    for(int r = 0; r < 256; r++) {
+        float depth = 2048.0f / (r + 8);
+        depth_lut[r] = (depth > 255) ? 255 : (uint8_t)depth;
+    }
+}
+
+// Palette index for a cell at full-turn angle and radius
+static inline uint8_t polar_index(uint8_t variant, uint8_t angle, uint8_t radius, uint16_t t, uint8_t scale) {
+    switch(variant) {
+        case POLAR_TUNNEL:
+            return (uint8_t)((angle << 1) + t) ^ (uint8_t)(depth_lut[radius] + (t << 1));
+        case POLAR_RINGS:
+            return radius * scale - (t << 2);
+        default: // POLAR_SPIRAL
+            return (angle << 1) + radius * scale - (t << 2);
+    }
+}
+
+// Color of the pixel at x on a line using map row angles/radii
+static inline uint16_t polar_pixel(uint8_t variant, const uint8_t *angles, const uint8_t *radii, bool lower,
+                                   uint16_t x, uint16_t t, uint8_t scale) {
+    uint16_t u;
+    uint8_t angle;
+    if(x < center_x) {
+        u = (center_x - 1 - x) >> map_shift;
+        angle = lower ? 128 - angles[u] : 128 + angles[u];
+    } else {
+        u = (x - center_x) >> map_shift;
+        angle = lower ? angles[u] : -angles[u];
+    }
+    return palette[polar_index(variant, angle, radii[u], t, scale)];
+}
+
+uint16_t *__render_func(polar_span)(uint16_t *p, uint8_t variant, uint16_t y, uint16_t x0, uint16_t x1, uint16_t t,
+                                    uint8_t scale, bool half) {
+    if(x1 <= x0) {
+        return p;
+    }
+
+    // Map row for this line, and whether it is below the middle (angles run
+    // 0-63 in the bottom right quadrant and are reflected for the others)
+    bool lower = y >= center_y;
+    uint16_t v = (lower ? y - center_y : center_y - 1 - y) >> map_shift;
+    const uint8_t *angles = angle_map[v];
+    const uint8_t *radii = radius_map[v];
+
+    uint16_t len = x1 - x0;
+    uint16_t *q = span_raw_stream(p, len);
+
+    if(half) {
+        // One sample for each pair of pixels, pairs start at even x so neighbouring spans line up
+        uint16_t color = polar_pixel(variant, angles, radii, lower, x0 & ~1u, t, scale);
+        *q++ = color;
+        for(uint16_t x = x0 + 1; x < x1; x++) {
+            if(!(x & 1)) {
+                color = polar_pixel(variant, angles, radii, lower, x, t, scale);
+            }
+            *q++ = color;
+        }
+        return span_raw_end(p, len);
+    }
+
+    // Left of the middle, where map columns run back towards the middle
+    uint16_t x = x0;
+    uint16_t split = MIN(MAX(x0, center_x), x1);
+    for(; x < split; x++) {
+        uint16_t u = (center_x - 1 - x) >> map_shift;
+        uint8_t angle = lower ? 128 - angles[u] : 128 + angles[u];
+        *q++ = palette[polar_index(variant, angle, radii[u], t, scale)];
+    }
+
+    // Right of the middle
+    for(; x < x1; x++) {
+        uint16_t u = (x - center_x) >> map_shift;
+        uint8_t angle = lower ? angles[u] : -angles[u];
+        *q++ = palette[polar_index(variant, angle, radii[u], t, scale)];
+    }
+
+    return span_raw_end(p, len);
+}
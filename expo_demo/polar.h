@@ -0,0 +1,30 @@
+// Tunnel, rings and spiral effects
+//
+// Angle and distance from the middle of the screen are looked up from maps
+// built once at start-up, so there is no atan2 or sqrt while drawing. The maps
+// only cover one quadrant; the other three are read back to front and/or
+// with the angle reflected. Per pixel an effect adds its time offsets to the
+// looked-up values and indexes the live palette (see palette.h).
+
+#ifndef POLAR_H
+#define POLAR_H
+
+#include "pico.h"
+
+enum {
+    POLAR_TUNNEL, // XOR texture on the inside of a tube, flying forwards
+    POLAR_RINGS,  // Concentric rings moving outwards
+    POLAR_SPIRAL  // Two-armed spiral turning
+};
+
+// Build the angle, radius and depth maps for the current video mode
+// (call once before drawing)
+void polar_init(void);
+
+// Write pixels x0 to x1 (exclusive) of line y of a polar effect at time t
+// scale sets the spacing of rings and spiral arms (1 = broad, larger = finer)
+// half computes one pixel in two and doubles it (half horizontal resolution)
+uint16_t *polar_span(uint16_t *p, uint8_t variant, uint16_t y, uint16_t x0, uint16_t x1, uint16_t t, uint8_t scale,
+                     bool half);
+
+#endif
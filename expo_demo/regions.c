@@ -0,0 +1,226 @@
+#include "regions.h"
+#include "span.h"
+#include "video_mode.h"
+#include "params.h"
+#include "effects.h"
+#include "osd.h"
+#include "symmetry.h"
+#include "wall.h"
+#include "wobble.h"
+#include "noise.h"
+#include "governor.h"
+#include "placement.h"
+
+// Region in quarters of the screen, showing the demo chosen for one slot
+typedef struct {
+    uint8_t x0, y0, x1, y1;
+    uint8_t slot;
+} region_def_t;
+
+typedef struct {
+    uint8_t count;
+    region_def_t regions[MAX_REGIONS];
+} layout_t;
+
+// Regions crossing any one line must be listed left to right
+static const layout_t layouts[LAYOUT_COUNT] = {
+    [LAYOUT_FULL] = {1, {
+        {0, 0, 4, 4, 0},
+    }},
+    [LAYOUT_SPLIT_V] = {2, {
+        {0, 0, 2, 4, 0},
+        {2, 0, 4, 4, 1},
+    }},
+    [LAYOUT_SPLIT_H] = {2, {
+        {0, 0, 4, 2, 0},
+        {0, 2, 4, 4, 1},
+    }},
+    [LAYOUT_QUAD] = {4, {
+        {0, 0, 2, 2, 0},
+        {2, 0, 4, 2, 1},
+        {0, 2, 2, 4, 2},
+        {2, 2, 4, 4, 3},
+    }},
+    [LAYOUT_INSET] = {5, {
+        {0, 0, 4, 1, 0},
+        {0, 1, 1, 3, 0},
+        {1, 1, 3, 3, 1},
+        {3, 1, 4, 3, 0},
+        {0, 3, 4, 4, 0},
+    }},
+};
+
+// Parameter holding the demo for each slot
+static const uint8_t slot_params[] = {
+    PARAM_DEMO,
+    PARAM_REGION1_DEMO,
+    PARAM_REGION2_DEMO,
+    PARAM_REGION3_DEMO,
+};
+
+// Black filler for gaps between regions (and demos left blank)
+static uint16_t *__render_func(draw_gap)(uint16_t *p, __unused uint16_t y, uint16_t x0, uint16_t x1) {
+    return span_color(p, 0, x1 - x0);
+}
+
+// Regions for the current frame in pixels
+typedef struct {
+    uint16_t x0, y0, x1, y1;
+    effect_span_t span;
+    // Bounds of all regions showing the same slot, which symmetry mirrors about
+    uint16_t slot_x0, slot_y0, slot_x1, slot_y1;
+} region_t;
+
+static region_t regions[MAX_REGIONS];
+static uint8_t region_count;
+
+// Symmetry mode applied to every region this frame
+static uint8_t symmetry;
+
+void regions_begin_frame(void) {
+    const layout_t *layout = &layouts[param(PARAM_LAYOUT)];
+    uint16_t width = vga_mode.width;
+    uint16_t height = vga_mode.height;
+
+    for(uint n = 0; n < layout->count; n++) {
+        const region_def_t *def = &layout->regions[n];
+        regions[n].x0 = def->x0 * width / 4;
+        regions[n].x1 = def->x1 * width / 4;
+        regions[n].y0 = def->y0 * height / 4;
+        regions[n].y1 = def->y1 * height / 4;
+        // Demos whose lines can't fit the scanline buffer are left blank
+        uint8_t demo = param(slot_params[def->slot]);
+        regions[n].span = governor_demo_fit[demo] ? effects[demo].span : draw_gap;
+    }
+    region_count = layout->count;
+
+    for(uint n = 0; n < region_count; n++) {
+        region_t *r = &regions[n];
+        r->slot_x0 = r->x0;
+        r->slot_y0 = r->y0;
+        r->slot_x1 = r->x1;
+        r->slot_y1 = r->y1;
+        for(uint m = 0; m < region_count; m++) {
+            if(layout->regions[m].slot == layout->regions[n].slot) {
+                r->slot_x0 = MIN(r->slot_x0, regions[m].x0);
+                r->slot_y0 = MIN(r->slot_y0, regions[m].y0);
+                r->slot_x1 = MAX(r->slot_x1, regions[m].x1);
+                r->slot_y1 = MAX(r->slot_y1, regions[m].y1);
+            }
+        }
+    }
+    symmetry = param(PARAM_SYMMETRY);
+}
+
+bool regions_show_demo(uint8_t demo) {
+    const layout_t *layout = &layouts[param(PARAM_LAYOUT)];
+    for(uint n = 0; n < layout->count; n++) {
+        if(param(slot_params[layout->regions[n].slot]) == demo) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Draw canvas pixels x0 to x1 of effect line y of region r
+static uint16_t *__render_func(draw_source)(uint16_t *p, const region_t *r, bool mirror, uint16_t y, uint16_t x0,
+                                            uint16_t x1) {
+    if(mirror) {
+        return symmetry_span(p, r->span, y, x0, x1, r->slot_x0 + wall_x0, r->slot_x1 + wall_x0);
+    }
+    return r->span(p, y, x0, x1);
+}
+
+// Draw canvas pixels x0 to x1 of effect line y of region r displaced by w, from
+// the pixels of its slot (or of the canvas, where the slot reaches the edge of
+// the screen, so the picture carries on across a video wall)
+static __noinline uint16_t *__render_func(draw_wobbled)(uint16_t *p, const region_t *r, bool mirror, wobble_line_t w,
+                                                        uint16_t y, uint16_t x0, uint16_t x1) {
+    uint16_t lo = r->slot_x0 + wall_x0;
+    uint16_t hi = r->slot_x1 + wall_x0;
+    // A mirrored line is drawn whole, so symmetry can reuse its left half
+    uint16_t s0 = lo, s1 = hi;
+    if(!mirror) {
+        lo = r->slot_x0 ? lo : 0;
+        hi = (r->slot_x1 < vga_mode.width) ? hi : wall_width;
+        wobble_source(w, lo, hi, x0, x1, &s0, &s1);
+    }
+    uint16_t scratch[PICO_SCANVIDEO_MAX_SCANLINE_BUFFER_WORDS * 2];
+    uint16_t *end = (s0 < s1) ? draw_source(scratch, r, mirror, y, s0, s1) : scratch;
+    return wobble_tokens(p, w, lo, hi, scratch, end, s0, x0, x1);
+}
+
+// Draw x0 to x1 of effect line y of region r displaced by w, or noise where the
+// mix layer covers the line (gaps are drawn as regions of draw_gap with no
+// symmetry). Effects draw in canvas coordinates, which are this screen's moved
+// to its place on a video wall
+static uint16_t *__render_func(draw_region_span)(uint16_t *p, const region_t *r, bool mirror, wobble_line_t w,
+                                                 uint16_t y, uint16_t x0, uint16_t x1) {
+    y += wall_y0;
+    x0 += wall_x0;
+    x1 += wall_x0;
+    if(r->span != draw_gap && noise_mixes(y)) {
+        return noise_span(p, y, x0, x1);
+    }
+    if(wobble_moves(w)) {
+        return draw_wobbled(p, r, mirror, w, y, x0, x1);
+    }
+    return draw_source(p, r, mirror, y, x0, x1);
+}
+
+// Draw all of region r on line y showing effect line src_y, cutting out the OSD
+// panel if it overlaps (regions are drawn left to right and tile the line, so
+// exactly one contains osd_x0)
+static uint16_t *__render_func(draw_clipped)(uint16_t *p, const region_t *r, bool mirror, wobble_line_t w,
+                                             uint16_t y, uint16_t src_y, bool osd, uint16_t osd_x0, uint16_t osd_x1) {
+    uint16_t x0 = r->x0;
+    uint16_t x1 = r->x1;
+    if(!osd || x1 <= osd_x0 || x0 >= osd_x1) {
+        return draw_region_span(p, r, mirror, w, src_y, x0, x1);
+    }
+    if(x0 < osd_x0) {
+        p = draw_region_span(p, r, mirror, w, src_y, x0, osd_x0);
+    }
+    if(x0 <= osd_x0) {
+        p = osd_span(p, y);
+    }
+    if(x1 > osd_x1) {
+        p = draw_region_span(p, r, mirror, w, src_y, MAX(x0, osd_x1), x1);
+    }
+    return p;
+}
+
+void __render_func(draw_regions)(scanvideo_scanline_buffer_t *buffer, uint16_t effect_y) {
+    uint16_t y = scanvideo_scanline_number(buffer->scanline_id);
+    uint16_t *p = (uint16_t *) buffer->data;
+    uint16_t x = 0;
+
+    uint16_t osd_x0, osd_x1;
+    bool osd = osd_covers_line(y, &osd_x0, &osd_x1);
+
+    bool mirror = symmetry_mirrors_x(symmetry);
+    // Gaps are black wherever they land, so they are never displaced
+    wobble_line_t w = wobble_line(effect_y);
+    wobble_line_t still = {0, WOBBLE_ONE};
+
+    for(uint n = 0; n < region_count; n++) {
+        const region_t *r = &regions[n];
+        if(effect_y < r->y0 || effect_y >= r->y1) {
+            continue;
+        }
+        // Black gap before this region
+        if(r->x0 > x) {
+            region_t gap = {.x0 = x, .x1 = r->x0, .span = draw_gap};
+            p = draw_clipped(p, &gap, false, still, y, y, osd, osd_x0, osd_x1);
+        }
+        uint16_t src_y = symmetry_line(symmetry, effect_y, r->slot_y0, r->slot_y1);
+        p = draw_clipped(p, r, mirror, w, y, src_y, osd, osd_x0, osd_x1);
+        x = r->x1;
+    }
+    if(x < vga_mode.width) {
+        region_t gap = {.x0 = x, .x1 = vga_mode.width, .span = draw_gap};
+        p = draw_clipped(p, &gap, false, still, y, y, osd, osd_x0, osd_x1);
+    }
+
+    span_end_line(buffer, p);
+}
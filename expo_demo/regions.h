@@ -0,0 +1,38 @@
+// Split-screen compositor
+//
+// A layout divides the screen into rectangular regions, each showing one
+// effect. On every line the regions that cross it are drawn left to right as
+// clipped spans, so an effect only costs the pixels it covers. Gaps are black.
+// The OSD panel is cut out of whichever spans it overlaps.
+
+#ifndef REGIONS_H
+#define REGIONS_H
+
+#include "pico.h"
+#include "pico/scanvideo.h"
+
+// Values of PARAM_LAYOUT
+enum {
+    LAYOUT_FULL,    // Slot 0 fills the screen
+    LAYOUT_SPLIT_V, // Slot 0 left half, slot 1 right half
+    LAYOUT_SPLIT_H, // Slot 0 top half, slot 1 bottom half
+    LAYOUT_QUAD,    // Slots 0-3 in the four quadrants
+    LAYOUT_INSET,   // Slot 1 in a centered window over slot 0
+    LAYOUT_COUNT
+};
+
+// Maximum number of regions in a layout
+#define MAX_REGIONS 8
+
+// Work out region rectangles for this frame from the layout parameters
+// (core 1, at frame boundary after params_apply_pending)
+void regions_begin_frame(void);
+
+// Draw one line of the current layout showing line effect_y of the effects
+// (normally the buffer's own line, the OSD is always drawn at that line)
+void draw_regions(scanvideo_scanline_buffer_t *buffer, uint16_t effect_y);
+
+// Whether the current layout parameters put demo in any slot (any core)
+bool regions_show_demo(uint8_t demo);
+
+#endif
@@ -0,0 +1,34 @@
+// Cheap random numbers
+//
+// rng_next steps an xorshift32 generator, for effects that want a stream of
+// random words. rng_hash (lowbias32) scrambles a value, for seeds and lookups
+// that must come out the same for the same input, e.g. on every board of a
+// video wall.
+
+#ifndef RNG_H
+#define RNG_H
+
+#include "pico.h"
+
+// Next word from an xorshift32 generator (state must not be 0, which it never
+// leaves)
+static inline uint32_t rng_next(uint32_t *state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// Integer hash, for values that differ a lot between neighbouring inputs
+static inline uint32_t rng_hash(uint32_t h) {
+    h ^= h >> 16;
+    h *= 0x7feb352du;
+    h ^= h >> 15;
+    h *= 0x846ca68bu;
+    h ^= h >> 16;
+    return h;
+}
+
+#endif
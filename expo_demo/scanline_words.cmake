@@ -0,0 +1,16 @@
+# Scanline buffer size for a video mode
+#
+# A line of the raw pixel demos (plasma, polar, life, noise) takes a halfword
+# per pixel and a few more for its tokens, so a buffer needs half the mode's
+# width in words and some to spare (see governor.h). Never less than
+# scanvideo's default of 180 words.
+function(scanline_words mode out)
+    set(words 180)
+    if(mode MATCHES "_([0-9]+)x[0-9]+")
+        math(EXPR need "${CMAKE_MATCH_1} / 2 + 16")
+        if(need GREATER words)
+            set(words ${need})
+        endif()
+    endif()
+    set(${out} ${words} PARENT_SCOPE)
+endfunction()
@@ -0,0 +1,298 @@
+#include "scroll.h"
+#include "span.h"
+#include "params.h"
+#include "regions.h"
+#include "wall.h"
+#include "rng.h"
+#include "placement.h"
+#include "pico/sync.h"
+
+// Tiles are TILE_SIZE strip pixels square, MAP_TILES across the strip
+#define TILE_SIZE 32
+#define MAP_TILES (SCROLL_WIDTH / TILE_SIZE)
+
+// Terrain height is interpolated between random values every LATTICE tiles
+#define LATTICE 4
+#define LATTICE_COLUMNS (MAP_TILES / LATTICE)
+
+// Runs kept per line: each tile adds at most three (its background either
+// side of its detail), fewer where it carries on a run of the tile before
+#define SCROLL_LINE_RUNS (3 * MAP_TILES)
+
+// A run is a color index in the top 6 bits and its length - 1 below
+#define RUN_LENGTH_BITS 10
+#define RUN(color, len) (((color) << RUN_LENGTH_BITS) | ((len) - 1))
+#define RUN_COLOR(run) ((run) >> RUN_LENGTH_BITS)
+#define RUN_LENGTH(run) (((run) & ((1u << RUN_LENGTH_BITS) - 1)) + 1)
+
+static_assert(SCROLL_WIDTH <= (1u << RUN_LENGTH_BITS), "run lengths must fit");
+
+typedef struct {
+    uint8_t count;
+    uint16_t runs[SCROLL_LINE_RUNS];
+} scroll_line_t;
+
+// Strip line n is kept in ring[n % SCROLL_RING_LINES]
+static scroll_line_t ring[SCROLL_RING_LINES];
+
+enum {
+    TILE_WATER,
+    TILE_SAND,
+    TILE_GRASS,
+    TILE_FOREST,
+    TILE_ROCK,
+};
+
+enum {
+    COLOR_WATER,
+    COLOR_WAVE,
+    COLOR_SAND,
+    COLOR_SAND_DARK,
+    COLOR_GRASS,
+    COLOR_GRASS_DARK,
+    COLOR_FOREST,
+    COLOR_CANOPY,
+    COLOR_TRUNK,
+    COLOR_ROCK,
+    COLOR_MORTAR,
+    COLOR_COUNT
+};
+
+static const uint16_t colors[COLOR_COUNT] = {
+    [COLOR_WATER]      = PICO_SCANVIDEO_PIXEL_FROM_RGB5(2, 7, 21),
+    [COLOR_WAVE]       = PICO_SCANVIDEO_PIXEL_FROM_RGB5(11, 18, 28),
+    [COLOR_SAND]       = PICO_SCANVIDEO_PIXEL_FROM_RGB5(27, 25, 15),
+    [COLOR_SAND_DARK]  = PICO_SCANVIDEO_PIXEL_FROM_RGB5(22, 18, 10),
+    [COLOR_GRASS]      = PICO_SCANVIDEO_PIXEL_FROM_RGB5(7, 20, 6),
+    [COLOR_GRASS_DARK] = PICO_SCANVIDEO_PIXEL_FROM_RGB5(5, 15, 4),
+    [COLOR_FOREST]     = PICO_SCANVIDEO_PIXEL_FROM_RGB5(2, 11, 4),
+    [COLOR_CANOPY]     = PICO_SCANVIDEO_PIXEL_FROM_RGB5(5, 17, 5),
+    [COLOR_TRUNK]      = PICO_SCANVIDEO_PIXEL_FROM_RGB5(13, 8, 4),
+    [COLOR_ROCK]       = PICO_SCANVIDEO_PIXEL_FROM_RGB5(16, 16, 16),
+    [COLOR_MORTAR]     = PICO_SCANVIDEO_PIXEL_FROM_RGB5(10, 10, 10),
+};
+
+// Canvas pixels per strip pixel, strip width in canvas pixels and strip lines
+// on the canvas
+static uint8_t scale;
+static uint16_t strip_width;
+static uint16_t visible_lines;
+
+// Half width of the tree canopy on each line of a forest tile (0 outside it)
+static uint8_t canopy[TILE_SIZE];
+
+// Strip line at the top of the screen and horizontal scroll in screen pixels
+// (core 1)
+static uint32_t top;
+static uint16_t offset_x;
+// Top line shown this frame (written by core 1) and lines encoded so far
+// (written by core 0)
+static volatile uint32_t shown_top;
+static volatile uint32_t ready_lines;
+
+// Core 0 state: the tile row lines are being encoded from
+static uint32_t map_row_index = 0xffffffff;
+static uint8_t map_tiles[MAP_TILES];
+static uint8_t map_variants[MAP_TILES];
+
+// Random terrain height 0-255 at a lattice point (wrapping across the strip)
+static uint8_t lattice(uint32_t row, uint column) {
+    return rng_hash(row * LATTICE_COLUMNS + column % LATTICE_COLUMNS) & 0xff;
+}
+
+// Work out the tiles of one tile row from the interpolated terrain height
+static void build_map_row(uint32_t tile_row) {
+    uint32_t row = tile_row / LATTICE;
+    uint fy = tile_row % LATTICE;
+    for(uint tx = 0; tx < MAP_TILES; tx++) {
+        uint column = tx / LATTICE;
+        uint fx = tx % LATTICE;
+        int top_height = lattice(row, column) * (LATTICE - fx) + lattice(row, column + 1) * fx;
+        int bottom_height = lattice(row + 1, column) * (LATTICE - fx) + lattice(row + 1, column + 1) * fx;
+        int height = (top_height * (LATTICE - fy) + bottom_height * fy) / (LATTICE * LATTICE);
+
+        uint32_t h = rng_hash(tile_row * MAP_TILES + tx + 0x9e3779b9);
+        height += (int)(h & 31) - 16;
+
+        uint8_t tile = TILE_ROCK;
+        if(height < 90) {
+            tile = TILE_WATER;
+        } else if(height < 110) {
+            tile = TILE_SAND;
+        } else if(height < 160) {
+            tile = TILE_GRASS;
+        } else if(height < 200) {
+            tile = TILE_FOREST;
+        }
+        map_tiles[tx] = tile;
+        map_variants[tx] = h >> 24;
+    }
+    map_row_index = tile_row;
+}
+
+static void add_run(scroll_line_t *line, uint8_t color, uint16_t len) {
+    if(!len) {
+        return;
+    }
+    if(line->count) {
+        uint16_t *last = &line->runs[line->count - 1];
+        if(RUN_COLOR(*last) == color) {
+            *last = RUN(RUN_COLOR(*last), RUN_LENGTH(*last) + len);
+            return;
+        }
+    }
+    line->runs[line->count++] = RUN(color, len);
+}
+
+// Runs for line ty of one tile: the background color with at most one detail
+static void tile_line(scroll_line_t *line, uint8_t tile, uint8_t variant, uint ty) {
+    static const uint8_t backgrounds[] = {
+        [TILE_WATER]  = COLOR_WATER,
+        [TILE_SAND]   = COLOR_SAND,
+        [TILE_GRASS]  = COLOR_GRASS,
+        [TILE_FOREST] = COLOR_FOREST,
+        [TILE_ROCK]   = COLOR_ROCK,
+    };
+    uint8_t background = backgrounds[tile];
+    uint8_t color = background;
+    uint x0 = 0, x1 = 0;
+
+    switch(tile) {
+        case TILE_WATER:
+            // Short waves, drifting right down the tile
+            if(ty % 8 == 2) {
+                x0 = (ty * 3 + variant) % (TILE_SIZE - 10);
+                x1 = x0 + 10;
+                color = COLOR_WAVE;
+            }
+            break;
+        case TILE_SAND:
+            if(ty == 9 || ty == 23) {
+                x0 = (variant + ty) % (TILE_SIZE - 3);
+                x1 = x0 + 3;
+                color = COLOR_SAND_DARK;
+            }
+            break;
+        case TILE_GRASS:
+            if(ty >= 12 && ty < 16) {
+                x0 = variant % (TILE_SIZE - 6) + (ty - 12);
+                x1 = x0 + 6 - 2 * (ty - 12);
+                color = COLOR_GRASS_DARK;
+            }
+            break;
+        case TILE_FOREST:
+            if(canopy[ty]) {
+                x0 = TILE_SIZE / 2 - canopy[ty];
+                x1 = TILE_SIZE / 2 + canopy[ty];
+                color = COLOR_CANOPY;
+            } else if(ty >= 25 && ty < 30) {
+                x0 = TILE_SIZE / 2 - 2;
+                x1 = TILE_SIZE / 2 + 2;
+                color = COLOR_TRUNK;
+            }
+            break;
+        case TILE_ROCK:
+            // Blocks in courses of 16 lines, the joints of alternate courses offset
+            if(ty % 16 == 0) {
+                x1 = TILE_SIZE;
+                color = COLOR_MORTAR;
+            } else {
+                x0 = (ty / 16) ? 6 : 22;
+                x1 = x0 + 2;
+                color = COLOR_MORTAR;
+            }
+            break;
+    }
+
+    add_run(line, background, x0);
+    add_run(line, color, x1 - x0);
+    add_run(line, background, TILE_SIZE - x1);
+}
+
+static void encode_line(scroll_line_t *line, uint32_t n) {
+    uint32_t tile_row = n / TILE_SIZE;
+    if(tile_row != map_row_index) {
+        build_map_row(tile_row);
+    }
+    line->count = 0;
+    for(uint tx = 0; tx < MAP_TILES; tx++) {
+        tile_line(line, map_tiles[tx], map_variants[tx], n % TILE_SIZE);
+    }
+}
+
+void scroll_init(void) {
+    // Lines on the canvas plus the lines scrolled in during a frame must fit the ring
+    scale = 1;
+    while((wall_height + scale - 1) / scale + SCROLL_MAX_SPEED > SCROLL_RING_LINES) {
+        scale++;
+    }
+    strip_width = SCROLL_WIDTH * scale;
+    visible_lines = (wall_height + scale - 1) / scale;
+
+    // Canopy is a circle of radius 11 centered 14 lines down
+    for(int ty = 0; ty < TILE_SIZE; ty++) {
+        int dy = ty - 14;
+        uint8_t half = 0;
+        while(dy * dy < 121 && (half + 1) * (half + 1) <= 121 - dy * dy) {
+            half++;
+        }
+        canopy[ty] = half;
+    }
+
+    for(uint32_t n = 0; n < SCROLL_RING_LINES; n++) {
+        encode_line(&ring[n], n);
+    }
+    top = 0;
+    offset_x = 0;
+    shown_top = 0;
+    ready_lines = SCROLL_RING_LINES;
+}
+
+void scroll_poll(void) {
+    if(!regions_show_demo(DEMO_SCROLL)) {
+        return;
+    }
+    // A slot is free once its line is above the top of the screen
+    uint32_t limit = shown_top + SCROLL_RING_LINES;
+    while(ready_lines < limit) {
+        uint32_t n = ready_lines;
+        encode_line(&ring[n % SCROLL_RING_LINES], n);
+        __mem_fence_release();
+        ready_lines = n + 1;
+    }
+}
+
+void scroll_begin_frame(uint steps) {
+    // Never scroll onto lines core 0 hasn't encoded yet (it catches up within
+    // a frame unless the background has just come back on screen)
+    uint32_t ready = ready_lines;
+    __mem_fence_acquire();
+    top = MIN(top + steps * param(PARAM_SCROLL_DY), ready - visible_lines);
+    shown_top = top;
+
+    offset_x = (offset_x + steps * param(PARAM_SCROLL_DX)) % strip_width;
+}
+
+uint16_t *__render_func(scroll_span)(uint16_t *p, uint16_t y, uint16_t x0, uint16_t x1) {
+    const scroll_line_t *line = &ring[(top + y / scale) % SCROLL_RING_LINES];
+
+    // Find the run under x0, and how much of it is left
+    uint32_t v = (offset_x + x0) % strip_width;
+    uint n = 0;
+    uint32_t run_end = RUN_LENGTH(line->runs[0]) * scale;
+    while(run_end <= v) {
+        run_end += RUN_LENGTH(line->runs[++n]) * scale;
+    }
+    uint32_t left = run_end - v;
+
+    // Then whole runs, wrapping around the end of the strip
+    uint16_t x = x0;
+    while(x < x1) {
+        uint16_t len = MIN(left, (uint32_t)(x1 - x));
+        p = span_color(p, colors[RUN_COLOR(line->runs[n])], len);
+        x += len;
+        n = (n + 1 == line->count) ? 0 : n + 1;
+        left = RUN_LENGTH(line->runs[n]) * scale;
+    }
+    return p;
+}
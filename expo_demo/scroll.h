@@ -0,0 +1,40 @@
+// Scrolling tile-map background
+//
+// The picture is a strip SCROLL_WIDTH pixels wide that wraps around, and
+// endless downwards. Its lines are kept in a ring of SCROLL_RING_LINES encoded
+// lines, each a list of color runs. Core 0 encodes a line once, just before
+// it scrolls into view, into the slot of a line that has scrolled off the top.
+// Scrolling only moves which ring line core 1 reads for a screen line and where
+// in the strip it starts reading, so a frame costs the few new lines rather
+// than the whole picture.
+//
+// Modes too tall for the ring show the strip at double size.
+
+#ifndef SCROLL_H
+#define SCROLL_H
+
+#include "pico.h"
+
+#define SCROLL_WIDTH 512
+#define SCROLL_RING_LINES 256
+
+// Highest scroll speed in strip lines per frame (core 0 keeps this many lines
+// ahead of the screen)
+#define SCROLL_MAX_SPEED 16
+
+// Work out the scale for the video mode and encode the first lines (call
+// once before drawing)
+void scroll_init(void);
+
+// Encode lines into the slots that have scrolled off the top, while the
+// background is on screen (core 0, call often)
+void scroll_poll(void);
+
+// Scroll by the speed parameters for each of steps animation steps, as far as
+// core 0 has encoded (core 1, at frame boundary)
+void scroll_begin_frame(uint steps);
+
+// Write pixels x0 to x1 (exclusive) of line y of the background
+uint16_t *scroll_span(uint16_t *p, uint16_t y, uint16_t x0, uint16_t x1);
+
+#endif
@@ -0,0 +1,476 @@
+#include "solid.h"
+#include "span.h"
+#include "params.h"
+#include "regions.h"
+#include "video_mode.h"
+#include "wall.h"
+#include "handoff.h"
+#include "trig.h"
+#include "persist.h"
+#include "placement.h"
+#include <math.h>
+#include <string.h>
+
+#define MAX_VERTS 128
+#define MAX_FACES 128
+// Every face is a quad
+#define FACE_SIDES 4
+
+// Lines covered by the edge tables (taller modes leave the bottom empty),
+// grouped into bands of 8 lines that each list the faces crossing them
+#define MAX_LINES 480
+#define BAND_SHIFT 3
+#define BANDS (MAX_LINES >> BAND_SHIFT)
+#define MAX_BAND_ENTRIES 2048
+
+// Model sizes, in the same units as the camera distance
+#define CUBE_HALF 128
+#define TORUS_MAJOR 12
+#define TORUS_MINOR 8
+#define TORUS_MAJOR_RADIUS 150
+#define TORUS_MINOR_RADIUS 64
+#define CAMERA_DISTANCE 640
+
+// Direction towards the light (up, left and behind the viewer), Q14
+static const int32_t light[3] = {-4915, -6554, -14189};
+
+typedef struct {
+    uint8_t v[FACE_SIDES];
+    int16_t normal[3]; // Outward unit normal, Q14
+    uint8_t r, g, b;   // Unlit color, 0-31
+} mesh_face_t;
+
+typedef struct {
+    uint8_t vert_count;
+    uint8_t face_count;
+    int16_t verts[MAX_VERTS][3];
+    mesh_face_t faces[MAX_FACES];
+} mesh_t;
+
+// Screen coordinates are in 1/16 pixels from the top left of this screen
+// (x can be far off it on a wide wall)
+typedef struct {
+    int16_t y0, y1; // y0 <= y1
+    int32_t x0, x1; // x at y0 and at y1
+    int32_t dxdy;   // Change in x per unit of y, 16.16
+} edge_t;
+
+typedef struct {
+    uint16_t color;
+    uint16_t line0, line1; // Lines touched (line1 exclusive)
+    uint16_t first_edge;
+} face_t;
+
+// One frame of a solid: visible faces back to front and the faces crossing
+// each band, back to front
+typedef struct {
+    face_t faces[MAX_FACES];
+    edge_t edges[MAX_FACES * FACE_SIDES];
+    uint16_t band_start[BANDS + 1];
+    uint8_t band_faces[MAX_BAND_ENTRIES];
+    bool wireframe;
+} scene_t;
+
+typedef struct {
+    scene_t scenes[2];
+    // Scene core 1 is drawing and the one core 0 builds
+    handoff_t handoff;
+    // Rotation about the x and y axes, 8.8 steps of trig_sin
+    uint16_t angle_x, angle_y;
+} solid_state_t;
+
+static mesh_t meshes[SOLID_COUNT];
+static solid_state_t solids[SOLID_COUNT];
+
+// Demo showing each solid
+static const uint8_t solid_demos[SOLID_COUNT] = {
+    [SOLID_CUBE]  = DEMO_CUBE,
+    [SOLID_TORUS] = DEMO_TORUS,
+};
+
+// Middle of the canvas on this screen, and distance to the eye, in 1/16 pixels
+static int32_t center_x16, center_y16, focal16;
+static uint16_t lines;
+
+// Core 0 scratch for one step
+static int32_t screen_x[MAX_VERTS], screen_y[MAX_VERTS];
+static int32_t camera[MAX_VERTS][3];
+static uint8_t order[MAX_FACES];
+static int32_t depth[MAX_FACES];
+static uint16_t band_cursor[BANDS];
+
+// Work out a face's normal and point it away from inside (a point within
+// the solid behind the face)
+static void finish_face(mesh_t *mesh, mesh_face_t *face, const float inside[3]) {
+    const int16_t *a = mesh->verts[face->v[0]];
+    const int16_t *b = mesh->verts[face->v[1]];
+    const int16_t *c = mesh->verts[face->v[2]];
+    const int16_t *d = mesh->verts[face->v[3]];
+
+    // Cross product of the diagonals
+    float p[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+    float q[3] = {d[0] - b[0], d[1] - b[1], d[2] - b[2]};
+    float n[3] = {p[1] * q[2] - p[2] * q[1], p[2] * q[0] - p[0] * q[2], p[0] * q[1] - p[1] * q[0]};
+    float len = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+    float out = 0;
+    for(int i = 0; i < 3; i++) {
+        out += n[i] * ((a[i] + c[i]) / 2.0f - inside[i]);
+    }
+    float sign = (out < 0) ? -1.0f : 1.0f;
+    for(int i = 0; i < 3; i++) {
+        face->normal[i] = (int16_t)(sign * n[i] * 16384 / len);
+    }
+}
+
+static void build_cube(mesh_t *mesh) {
+    static const uint8_t quads[6][FACE_SIDES] = {
+        {0, 1, 3, 2}, {4, 6, 7, 5}, {0, 2, 6, 4}, {1, 5, 7, 3}, {0, 4, 5, 1}, {2, 3, 7, 6},
+    };
+    static const uint8_t colors[6][3] = {
+        {31, 4, 4}, {4, 31, 4}, {4, 8, 31}, {31, 31, 4}, {4, 31, 31}, {31, 4, 31},
+    };
+    static const float middle[3] = {0, 0, 0};
+
+    mesh->vert_count = 8;
+    for(uint i = 0; i < 8; i++) {
+        mesh->verts[i][0] = (i & 1) ? CUBE_HALF : -CUBE_HALF;
+        mesh->verts[i][1] = (i & 2) ? CUBE_HALF : -CUBE_HALF;
+        mesh->verts[i][2] = (i & 4) ? CUBE_HALF : -CUBE_HALF;
+    }
+    mesh->face_count = 6;
+    for(uint f = 0; f < 6; f++) {
+        mesh_face_t *face = &mesh->faces[f];
+        memcpy(face->v, quads[f], FACE_SIDES);
+        face->r = colors[f][0];
+        face->g = colors[f][1];
+        face->b = colors[f][2];
+        finish_face(mesh, face, middle);
+    }
+}
+
+static void build_torus(mesh_t *mesh) {
+    mesh->vert_count = TORUS_MAJOR * TORUS_MINOR;
+    for(uint i = 0; i < TORUS_MAJOR; i++) {
+        float u = i * 2 * (float)M_PI / TORUS_MAJOR;
+        for(uint j = 0; j < TORUS_MINOR; j++) {
+            float v = j * 2 * (float)M_PI / TORUS_MINOR;
+            float ring = TORUS_MAJOR_RADIUS + TORUS_MINOR_RADIUS * cosf(v);
+            int16_t *vert = mesh->verts[i * TORUS_MINOR + j];
+            vert[0] = (int16_t)(ring * cosf(u));
+            vert[1] = (int16_t)(TORUS_MINOR_RADIUS * sinf(v));
+            vert[2] = (int16_t)(ring * sinf(u));
+        }
+    }
+
+    mesh->face_count = TORUS_MAJOR * TORUS_MINOR;
+    for(uint i = 0; i < TORUS_MAJOR; i++) {
+        uint i1 = (i + 1) % TORUS_MAJOR;
+        // Middle of the tube between the face's two rings
+        float u = (i + 0.5f) * 2 * (float)M_PI / TORUS_MAJOR;
+        float inside[3] = {TORUS_MAJOR_RADIUS * cosf(u), 0, TORUS_MAJOR_RADIUS * sinf(u)};
+        for(uint j = 0; j < TORUS_MINOR; j++) {
+            uint j1 = (j + 1) % TORUS_MINOR;
+            mesh_face_t *face = &mesh->faces[i * TORUS_MINOR + j];
+            face->v[0] = i * TORUS_MINOR + j;
+            face->v[1] = i1 * TORUS_MINOR + j;
+            face->v[2] = i1 * TORUS_MINOR + j1;
+            face->v[3] = i * TORUS_MINOR + j1;
+            // Checkered orange and teal
+            bool odd = (i + j) & 1;
+            face->r = odd ? 31 : 2;
+            face->g = odd ? 16 : 22;
+            face->b = odd ? 2 : 26;
+            finish_face(mesh, face, inside);
+        }
+    }
+}
+
+void solid_init(void) {
+    center_x16 = wall_width * 8 - wall_x0 * 16;
+    center_y16 = wall_height * 8 - wall_y0 * 16;
+    focal16 = wall_height * 7 / 8 * 16;
+    lines = MIN(vga_mode.height, MAX_LINES);
+
+    if(!persist_table(PERSIST_TABLE_SOLID_MESHES, meshes, sizeof(meshes))) {
+        build_cube(&meshes[SOLID_CUBE]);
+        build_torus(&meshes[SOLID_TORUS]);
+    }
+
+    for(uint s = 0; s < SOLID_COUNT; s++) {
+        handoff_init(&solids[s].handoff);
+    }
+}
+
+static void add_edge(edge_t *e, uint a, uint b) {
+    if(screen_y[a] > screen_y[b]) {
+        uint swap = a;
+        a = b;
+        b = swap;
+    }
+    int32_t y0 = screen_y[a], y1 = screen_y[b];
+    int32_t x0 = screen_x[a], x1 = screen_x[b];
+    int64_t dxdy = (y1 > y0) ? ((int64_t)(x1 - x0) << 16) / (y1 - y0) : 0;
+    e->dxdy = (int32_t)MAX(MIN(dxdy, INT32_MAX), INT32_MIN);
+
+    // On a tall wall the ends of an edge can be screens away, cut it where y
+    // leaves the range of the edge table (far from this screen)
+    if(y0 < INT16_MIN) {
+        x0 += (int32_t)(((int64_t)(INT16_MIN - y0) * e->dxdy) >> 16);
+        y0 = INT16_MIN;
+    }
+    if(y1 > INT16_MAX) {
+        x1 -= (int32_t)(((int64_t)(y1 - INT16_MAX) * e->dxdy) >> 16);
+        y1 = INT16_MAX;
+    }
+    e->y0 = y0;
+    e->y1 = y1;
+    e->x0 = x0;
+    e->x1 = x1;
+}
+
+void solid_step(uint8_t solid, uint steps) {
+    solid_state_t *s = &solids[solid];
+    const mesh_t *mesh = &meshes[solid];
+
+    uint16_t speed = steps * param(PARAM_SPEED_INC);
+    s->angle_y += speed * 96;
+    s->angle_x += speed * 64;
+    int32_t sy = trig_sin[(s->angle_y >> 8) & 0xff], cy = trig_sin[((s->angle_y >> 8) + 64) & 0xff];
+    int32_t sx = trig_sin[(s->angle_x >> 8) & 0xff], cx = trig_sin[((s->angle_x >> 8) + 64) & 0xff];
+
+    // Rotation about y then about x, Q14
+    int32_t m[3][3] = {
+        {cy, 0, sy},
+        {(sx * sy) >> 14, cx, -((sx * cy) >> 14)},
+        {-((cx * sy) >> 14), sx, (cx * cy) >> 14},
+    };
+
+    // Rotate into camera space and project
+    for(uint v = 0; v < mesh->vert_count; v++) {
+        const int16_t *in = mesh->verts[v];
+        int32_t *out = camera[v];
+        for(uint r = 0; r < 3; r++) {
+            out[r] = (m[r][0] * in[0] + m[r][1] * in[1] + m[r][2] * in[2]) >> 14;
+        }
+        out[2] += CAMERA_DISTANCE;
+        screen_x[v] = center_x16 + out[0] * focal16 / out[2];
+        screen_y[v] = center_y16 + out[1] * focal16 / out[2];
+    }
+
+    // Keep faces turned towards the eye, sorted far to near (insertion sort)
+    uint visible = 0;
+    for(uint f = 0; f < mesh->face_count; f++) {
+        const mesh_face_t *face = &mesh->faces[f];
+        int32_t view = 0;
+        int32_t z = 0;
+        for(uint r = 0; r < 3; r++) {
+            int32_t n = (m[r][0] * face->normal[0] + m[r][1] * face->normal[1] + m[r][2] * face->normal[2]) >> 14;
+            int32_t mid = (camera[face->v[0]][r] + camera[face->v[2]][r]) / 2;
+            view += n * mid;
+        }
+        if(view >= 0) {
+            continue;
+        }
+        for(uint k = 0; k < FACE_SIDES; k++) {
+            z += camera[face->v[k]][2];
+        }
+
+        uint i = visible++;
+        for(; i > 0 && depth[i - 1] < z; i--) {
+            depth[i] = depth[i - 1];
+            order[i] = order[i - 1];
+        }
+        depth[i] = z;
+        order[i] = f;
+    }
+
+    scene_t *scene = &s->scenes[handoff_back(&s->handoff)];
+    scene->wireframe = param(PARAM_WIREFRAME);
+
+    // Shade each face and add its edges, counting the faces in each band
+    memset(scene->band_start, 0, sizeof(scene->band_start));
+    uint face_count = 0;
+    uint entries = 0;
+    for(uint n = 0; n < visible; n++) {
+        const mesh_face_t *mf = &mesh->faces[order[n]];
+        face_t *face = &scene->faces[face_count];
+
+        // Lambert shading with some ambient light
+        int32_t lit = 0;
+        for(uint r = 0; r < 3; r++) {
+            int32_t normal = (m[r][0] * mf->normal[0] + m[r][1] * mf->normal[1] + m[r][2] * mf->normal[2]) >> 14;
+            lit += (normal * light[r]) >> 14;
+        }
+        uint level = 64 + ((MAX(lit, 0) * 3) >> 8);
+        face->color = PICO_SCANVIDEO_PIXEL_FROM_RGB5((mf->r * level) >> 8, (mf->g * level) >> 8, (mf->b * level) >> 8);
+
+        int32_t y_min = INT32_MAX, y_max = INT32_MIN;
+        face->first_edge = face_count * FACE_SIDES;
+        for(uint k = 0; k < FACE_SIDES; k++) {
+            add_edge(&scene->edges[face->first_edge + k], mf->v[k], mf->v[(k + 1) % FACE_SIDES]);
+            y_min = MIN(y_min, screen_y[mf->v[k]]);
+            y_max = MAX(y_max, screen_y[mf->v[k]]);
+        }
+        int32_t line0 = MAX(y_min >> 4, 0);
+        int32_t line1 = MIN((y_max >> 4) + 1, lines);
+        if(line0 >= line1) {
+            continue;
+        }
+        face->line0 = line0;
+        face->line1 = line1;
+
+        // Drop the face if the band lists are full (far more faces than the meshes have)
+        uint band0 = face->line0 >> BAND_SHIFT;
+        uint band1 = (face->line1 - 1) >> BAND_SHIFT;
+        if(entries + band1 - band0 + 1 > MAX_BAND_ENTRIES) {
+            continue;
+        }
+        entries += band1 - band0 + 1;
+        for(uint band = band0; band <= band1; band++) {
+            scene->band_start[band + 1]++;
+        }
+        face_count++;
+    }
+
+    // List the faces in each band, keeping them back to front
+    for(uint band = 0; band < BANDS; band++) {
+        scene->band_start[band + 1] += scene->band_start[band];
+        band_cursor[band] = scene->band_start[band];
+    }
+    for(uint n = 0; n < face_count; n++) {
+        const face_t *face = &scene->faces[n];
+        for(uint band = face->line0 >> BAND_SHIFT; band <= (face->line1 - 1u) >> BAND_SHIFT; band++) {
+            scene->band_faces[band_cursor[band]++] = n;
+        }
+    }
+
+    handoff_publish(&s->handoff);
+}
+
+void solid_poll(void) {
+    // Step once for each frame since the last step, and only while the solid
+    // is on screen
+    for(uint s = 0; s < SOLID_COUNT; s++) {
+        uint steps;
+        if(!regions_show_demo(solid_demos[s]) || !(steps = handoff_begin_step(&solids[s].handoff))) {
+            continue;
+        }
+        solid_step(s, steps);
+    }
+}
+
+void solid_begin_frame(void) {
+    for(uint s = 0; s < SOLID_COUNT; s++) {
+        handoff_take(&solids[s].handoff);
+    }
+}
+
+// Run of one color, x0 to x1 (exclusive)
+typedef struct {
+    uint16_t x0, x1;
+    uint16_t color;
+} piece_t;
+
+// Add the parts of x0 to x1 (clipped to the span) that no piece covers yet,
+// keeping pieces sorted by x. Returns the new piece count
+static uint add_piece(piece_t *pieces, uint count, int32_t x0, int32_t x1, uint16_t color, uint16_t span_x0,
+                      uint16_t span_x1) {
+    int32_t x = MAX(x0, span_x0);
+    int32_t end = MIN(x1, span_x1);
+    uint i = 0;
+    while(x < end) {
+        while(i < count && pieces[i].x1 <= x) {
+            i++;
+        }
+        if(i < count && pieces[i].x0 <= x) {
+            // Covered by a nearer face
+            x = pieces[i].x1;
+            continue;
+        }
+        if(count == SOLID_LINE_PIECES) {
+            break;
+        }
+        int32_t gap_end = (i < count) ? MIN(pieces[i].x0, end) : end;
+        memmove(&pieces[i + 1], &pieces[i], (count - i) * sizeof(piece_t));
+        pieces[i] = (piece_t){x, gap_end, color};
+        count++;
+        i++;
+        x = gap_end;
+    }
+    return count;
+}
+
+// x where an edge is at height t (1/16 pixels)
+static inline int32_t edge_x(const edge_t *e, int32_t t) {
+    return e->x0 + (int32_t)(((int64_t)(t - e->y0) * e->dxdy) >> 16);
+}
+
+uint16_t *__render_func(solid_span)(uint8_t solid, uint16_t *p, uint16_t y, uint16_t x0, uint16_t x1) {
+    // Canvas coordinates to this screen's
+    y -= wall_y0;
+    x0 -= wall_x0;
+    x1 -= wall_x0;
+    if(y >= lines) {
+        return span_color(p, 0, x1 - x0);
+    }
+
+    const solid_state_t *s = &solids[solid];
+    const scene_t *scene = &s->scenes[s->handoff.front];
+    uint band = y >> BAND_SHIFT;
+    int32_t top = y * 16;
+    piece_t pieces[SOLID_LINE_PIECES];
+    uint count = 0;
+
+    // Near to far, so nearer faces claim their pixels first
+    for(int n = scene->band_start[band + 1] - 1; n >= (int)scene->band_start[band]; n--) {
+        const face_t *face = &scene->faces[scene->band_faces[n]];
+        if(y < face->line0 || y >= face->line1) {
+            continue;
+        }
+        const edge_t *edges = &scene->edges[face->first_edge];
+
+        if(scene->wireframe) {
+            // Each edge covers the pixels it passes through between the top and bottom of the line
+            for(uint k = 0; k < FACE_SIDES; k++) {
+                const edge_t *e = &edges[k];
+                if(e->y1 < top || e->y0 >= top + 16) {
+                    continue;
+                }
+                int32_t xa = e->x0, xb = e->x1;
+                if(e->y1 > e->y0) {
+                    xa = edge_x(e, MAX(top, e->y0));
+                    xb = edge_x(e, MIN(top + 16, e->y1));
+                }
+                count = add_piece(pieces, count, MIN(xa, xb) >> 4, (MAX(xa, xb) >> 4) + 1, face->color, x0, x1);
+            }
+            continue;
+        }
+
+        // Faces are convex, so the pixels with centers between the leftmost
+        // and rightmost edge crossings at the middle of the line
+        int32_t middle = top + 8;
+        int32_t left = INT32_MAX, right = INT32_MIN;
+        for(uint k = 0; k < FACE_SIDES; k++) {
+            const edge_t *e = &edges[k];
+            if(middle < e->y0 || middle >= e->y1) {
+                continue;
+            }
+            int32_t x = edge_x(e, middle);
+            left = MIN(left, x);
+            right = MAX(right, x);
+        }
+        if(left < right) {
+            count = add_piece(pieces, count, (left + 7) >> 4, (right + 7) >> 4, face->color, x0, x1);
+        }
+    }
+
+    // Background shows between the pieces
+    uint16_t x = x0;
+    for(uint i = 0; i < count; i++) {
+        p = span_color(p, 0, pieces[i].x0 - x);
+        p = span_color(p, pieces[i].color, pieces[i].x1 - pieces[i].x0);
+        x = pieces[i].x1;
+    }
+    return span_color(p, 0, x1 - x);
+}
@@ -0,0 +1,42 @@
+// Rotating 3D solids (cube and torus), flat-shaded or wireframe
+//
+// Core 0 rotates and projects the mesh once per frame in fixed point, culls
+// faces turned away, shades the rest and sorts them back to front. Their
+// edges go into an edge table, and each band of 8 lines lists the faces that
+// cross it. Core 1 picks up the newest table at the frame boundary. On each
+// line it only visits the faces listed for its band, works out where their
+// edges cross the line and writes the visible parts as color runs, so there is
+// no framebuffer and a line costs the edges that are active on it.
+
+#ifndef SOLID_H
+#define SOLID_H
+
+#include "pico.h"
+
+// Most runs on one line, which keeps a busy line within the scanline buffer
+#define SOLID_LINE_PIECES 32
+
+enum {
+    SOLID_CUBE,
+    SOLID_TORUS,
+    SOLID_COUNT
+};
+
+// Build the meshes and lookup tables (call once before drawing)
+void solid_init(void);
+
+// Step each solid that is on screen if core 1 has picked up its last frame
+// (core 0, call often)
+void solid_poll(void);
+
+// Rotate a solid steps frames on and publish its edge table to core 1
+// (core 0, once core 1 has picked up the last step)
+void solid_step(uint8_t solid, uint steps);
+
+// Switch to the newest edge tables (core 1, at frame boundary)
+void solid_begin_frame(void);
+
+// Write pixels x0 to x1 (exclusive) of line y of a solid
+uint16_t *solid_span(uint8_t solid, uint16_t *p, uint16_t y, uint16_t x0, uint16_t x1);
+
+#endif
@@ -0,0 +1,167 @@
+// Helpers for writing composable scanline tokens one horizontal span at a time
+//
+// Spans can start and end at any pixel, so several effects can share a line.
+// Each helper returns the advanced data pointer.
+
+#ifndef SPAN_H
+#define SPAN_H
+
+#include "pico.h"
+#include "pico/scanvideo.h"
+#include "pico/scanvideo/composable_scanline.h"
+
+// Tokens are written with 32-bit stores where the data pointer allows (scanline
+// buffers are word aligned, so a token's alignment follows from p)
+typedef uint32_t __attribute__((may_alias)) span_word_t;
+
+// Whether p is at the start of a word
+static inline bool span_aligned(const uint16_t *p) {
+    return !((uintptr_t)p & 2);
+}
+
+// Two halfwords in one store (p must be word aligned)
+static inline uint16_t *span_word(uint16_t *p, uint16_t first, uint16_t second) {
+    *(span_word_t *)p = first | ((uint32_t)second << 16);
+    return p + 2;
+}
+
+// Run of one color, any length (nothing is written for len = 0)
+static inline uint16_t *span_color(uint16_t *p, uint16_t color, uint16_t len) {
+    if(len >= 3) {
+        // One word store and one halfword store, whichever way the token is aligned
+        if(span_aligned(p)) {
+            p = span_word(p, COMPOSABLE_COLOR_RUN, color);
+            *p = len - 3;
+            return p + 1;
+        }
+        *p = COMPOSABLE_COLOR_RUN;
+        return span_word(p + 1, color, len - 3);
+    }
+    if(len == 2) {
+        if(span_aligned(p)) {
+            p = span_word(p, COMPOSABLE_RAW_2P, color);
+            *p = color;
+            return p + 1;
+        }
+        *p = COMPOSABLE_RAW_2P;
+        return span_word(p + 1, color, color);
+    }
+    if(len == 1) {
+        if(span_aligned(p)) {
+            return span_word(p, COMPOSABLE_RAW_1P, color);
+        }
+        p[0] = COMPOSABLE_RAW_1P;
+        p[1] = color;
+        return p + 2;
+    }
+    return p;
+}
+
+// Start a span of len (>= 1) individually colored pixels
+// The first pixel goes in p[1], the rest are written from the returned pointer
+static inline uint16_t *span_raw_begin(uint16_t *p, uint16_t len) {
+    if(len >= 3) {
+        p[0] = COMPOSABLE_RAW_RUN;
+        p[2] = len - 3;
+        return p + 3;
+    }
+    p[0] = (len == 2) ? COMPOSABLE_RAW_2P : COMPOSABLE_RAW_1P;
+    return p + 2;
+}
+
+// Start a span of len (>= 1) individually colored pixels that are all written
+// in order from the returned pointer (for loops that write pixels in several
+// passes). Finish with span_raw_end once every pixel is written
+static inline uint16_t *span_raw_stream(uint16_t *p, uint16_t len) {
+    return p + ((len >= 3) ? 2 : 1);
+}
+
+// Fill in the token for a span started with span_raw_stream, returns the end of the span
+static inline uint16_t *span_raw_end(uint16_t *p, uint16_t len) {
+    if(len >= 3) {
+        // First pixel was written where the length goes
+        p[0] = COMPOSABLE_RAW_RUN;
+        p[1] = p[2];
+        p[2] = len - 3;
+        return p + len + 2;
+    }
+    p[0] = (len == 2) ? COMPOSABLE_RAW_2P : COMPOSABLE_RAW_1P;
+    return p + len + 1;
+}
+
+
+// Stripes of colors a and b, each width pixels, starting phase pixels into a
+// stripe of a then b (phase < 2 * width), as a color run per stripe
+static inline uint16_t *span_stripes(uint16_t *p, uint16_t a, uint16_t b, uint16_t width,
+                                     uint16_t phase, uint16_t len) {
+    if(phase >= width) {
+        uint16_t swap = a;
+        a = b;
+        b = swap;
+        phase -= width;
+    }
+    uint16_t first = width - phase;
+    if(len <= first) {
+        return span_color(p, a, len);
+    }
+    p = span_color(p, a, first);
+    len -= first;
+    while(len > width) {
+        p = span_color(p, b, width);
+        len -= width;
+        uint16_t swap = a;
+        a = b;
+        b = swap;
+    }
+    return span_color(p, b, len);
+}
+
+// Reading back tokens written by the helpers above (COLOR_RUN, RAW_RUN, RAW_1P
+// and RAW_2P only)
+
+// Number of pixels drawn by the token at t
+static inline uint16_t span_token_pixels(const uint16_t *t) {
+    if(t[0] == COMPOSABLE_COLOR_RUN || t[0] == COMPOSABLE_RAW_RUN) {
+        return t[2] + 3;
+    }
+    return (t[0] == COMPOSABLE_RAW_2P) ? 2 : 1;
+}
+
+// Number of halfwords taken by the token at t
+static inline uint16_t span_token_size(const uint16_t *t) {
+    if(t[0] == COMPOSABLE_RAW_RUN) {
+        return t[2] + 5;
+    }
+    return (t[0] == COMPOSABLE_RAW_1P) ? 2 : 3;
+}
+
+// Color of pixel n of the token at t
+static inline uint16_t span_token_pixel(const uint16_t *t, uint16_t n) {
+    if(n == 0 || t[0] == COMPOSABLE_COLOR_RUN) {
+        return t[1];
+    }
+    return (t[0] == COMPOSABLE_RAW_RUN) ? t[n + 2] : t[n + 1];
+}
+
+// Finish a line and hand it back to scanvideo
+static inline void span_end_line(scanvideo_scanline_buffer_t *buffer, uint16_t *p) {
+    // Black pixel to end line (required to prevent color from bleeding into blanking),
+    // then end of line with alignment padding
+    // Use COMPOSABLE_EOL_ALIGN if number of tokens used is odd, COMPOSABLE_EOL_SKIP_ALIGN if even
+    if(span_aligned(p)) {
+        p = span_word(p, COMPOSABLE_RAW_1P, 0);
+        p = span_word(p, COMPOSABLE_EOL_SKIP_ALIGN, 0);
+    } else {
+        *p = COMPOSABLE_RAW_1P;
+        p = span_word(p + 1, 0, COMPOSABLE_EOL_ALIGN);
+    }
+
+    // Set number of words used and check if it exceeds buffer size
+    buffer->data_used = ((uint32_t *) p) - buffer->data;
+    assert(buffer->data_used < buffer->data_max);
+
+    // Set buffer status to be ready for use
+    buffer->status = SCANLINE_OK;
+}
+
+#endif
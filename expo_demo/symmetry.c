@@ -0,0 +1,86 @@
+#include "symmetry.h"
+#include "span.h"
+#include "placement.h"
+
+// Halfwords taken by a token of type t drawing len pixels (written with span_color or span_raw_begin)
+static uint16_t __render_func(token_size)(const uint16_t *t, uint16_t len) {
+    if(len == 1) {
+        return 2;
+    }
+    if(len == 2 || t[0] == COMPOSABLE_COLOR_RUN) {
+        return 3;
+    }
+    return len + 2;
+}
+
+// Write the pixels of the tokens from src to end in reverse order, leaving out
+// the last skip pixels. Tokens are read front to back and placed back to front,
+// so no list of token positions is needed.
+static uint16_t *__render_func(reverse_tokens)(uint16_t *p, const uint16_t *src, const uint16_t *end, uint16_t skip) {
+    // Pixels to write and the space they take
+    uint16_t total = 0;
+    for(const uint16_t *t = src; t < end; t += span_token_size(t)) {
+        total += span_token_pixels(t);
+    }
+    uint16_t keep = total - skip;
+    uint16_t size = 0;
+    uint16_t x = 0;
+    for(const uint16_t *t = src; t < end && x < keep; t += span_token_size(t)) {
+        uint16_t len = MIN(span_token_pixels(t), keep - x);
+        size += token_size(t, len);
+        x += len;
+    }
+
+    uint16_t *out = p + size;
+    x = 0;
+    for(const uint16_t *t = src; t < end && x < keep; t += span_token_size(t)) {
+        uint16_t len = MIN(span_token_pixels(t), keep - x);
+        uint16_t *q = out - token_size(t, len);
+        out = q;
+        x += len;
+
+        if(t[0] == COMPOSABLE_COLOR_RUN) {
+            span_color(q, t[1], len);
+            continue;
+        }
+        uint16_t *first = q + 1;
+        q = span_raw_begin(q, len);
+        *first = span_token_pixel(t, len - 1);
+        for(int n = len - 2; n >= 0; n--) {
+            *q++ = span_token_pixel(t, n);
+        }
+    }
+    return p + size;
+}
+
+// Mirror image of source pixels s0 to s1 drawn on their own (only needed when
+// part of the line is drawn, cut by the OSD or a split slot, so the left half
+// can't be reused)
+static __noinline uint16_t *__render_func(reverse_source)(uint16_t *p, effect_span_t span, uint16_t y,
+                                                         uint16_t s0, uint16_t s1) {
+    uint16_t scratch[PICO_SCANVIDEO_MAX_SCANLINE_BUFFER_WORDS * 2];
+    uint16_t *end = span(scratch, y, s0, s1);
+    return reverse_tokens(p, scratch, end, 0);
+}
+
+uint16_t *__render_func(symmetry_span)(uint16_t *p, effect_span_t span, uint16_t y, uint16_t x0, uint16_t x1,
+                                       uint16_t rx0, uint16_t rx1) {
+    // Left half (including the middle pixel of odd widths) is drawn as normal
+    uint16_t mid = rx0 + (rx1 - rx0 + 1) / 2;
+    uint16_t *left = p;
+    if(x0 < mid) {
+        p = span(p, y, x0, MIN(x1, mid));
+    }
+    if(x1 <= mid) {
+        return p;
+    }
+
+    // Pixel x of the right half shows pixel rx0 + rx1 - 1 - x
+    uint16_t s0 = rx0 + rx1 - x1;
+    uint16_t s1 = rx0 + rx1 - MAX(x0, mid);
+    if(x0 == rx0 && x1 == rx1) {
+        // Whole line: the right half is the left half reversed, less the middle pixel
+        return reverse_tokens(p, left, p, mid - s1);
+    }
+    return reverse_source(p, span, y, s0, s1);
+}
@@ -0,0 +1,45 @@
+// Mirror and kaleidoscope modes
+//
+// A mirrored region only renders its left half. The right half is made by
+// walking the tokens just written for the left half backwards and writing
+// them out again in reverse pixel order, which costs a copy of the encoded
+// runs rather than the effect itself (a color run reverses to itself). The
+// bottom half of a region shows the top half's lines in reverse order.
+//
+// The compositor mirrors each region about the bounds of its layout slot, so a
+// slot made of several rectangles (LAYOUT_INSET) still mirrors as one picture.
+
+#ifndef SYMMETRY_H
+#define SYMMETRY_H
+
+#include "pico.h"
+#include "effects.h"
+
+// Values of PARAM_SYMMETRY
+enum {
+    SYMMETRY_NONE,
+    SYMMETRY_MIRROR_X,     // Right half mirrors the left half
+    SYMMETRY_MIRROR_Y,     // Bottom half mirrors the top half
+    SYMMETRY_KALEIDOSCOPE, // Both, so the top-left quarter fills the region
+    SYMMETRY_COUNT
+};
+
+// Source line for line y of an area covering lines y0 to y1 (exclusive)
+static inline uint16_t symmetry_line(uint8_t mode, uint16_t y, uint16_t y0, uint16_t y1) {
+    if((mode == SYMMETRY_MIRROR_Y || mode == SYMMETRY_KALEIDOSCOPE) && y >= y0 + (y1 - y0 + 1) / 2) {
+        return y0 + y1 - 1 - y;
+    }
+    return y;
+}
+
+// Whether mode mirrors each line left to right
+static inline bool symmetry_mirrors_x(uint8_t mode) {
+    return mode == SYMMETRY_MIRROR_X || mode == SYMMETRY_KALEIDOSCOPE;
+}
+
+// Write pixels x0 to x1 (exclusive) of line y of span mirrored about the
+// middle of rx0 to rx1 (x0 to x1 must lie within rx0 to rx1)
+uint16_t *symmetry_span(uint16_t *p, effect_span_t span, uint16_t y, uint16_t x0, uint16_t x1,
+                        uint16_t rx0, uint16_t rx1);
+
+#endif
@@ -0,0 +1,74 @@
+#include "telemetry.h"
+#include "video_mode.h"
+#include "placement.h"
+#include "hardware/structs/xip_ctrl.h"
+
+volatile render_stats_t render_stats;
+
+// Running totals for the frame in progress
+static uint32_t line_max;
+static uint32_t line_total;
+static uint32_t line_count;
+static int32_t queue_min;
+static uint32_t late_lines;
+
+void telemetry_init(void) {
+    // Each generated line is shown yscale times, one h_total at a time
+    const scanvideo_timing_t *timing = vga_mode.default_timing;
+    uint64_t line_clocks = (uint64_t)timing->h_total * vga_mode.yscale;
+    render_stats.line_budget_us = line_clocks * 1000000 / timing->clock_freq;
+    render_stats.frame = 0;
+    render_stats.headroom_pct = 100;
+    render_stats.queue_depth = PICO_SCANVIDEO_SCANLINE_BUFFER_COUNT;
+    render_stats.queue_min = PICO_SCANVIDEO_SCANLINE_BUFFER_COUNT;
+    queue_min = PICO_SCANVIDEO_SCANLINE_BUFFER_COUNT;
+    render_stats.xip_hit_pct = 100;
+
+    // Start the cache counters from the first frame (writing clears them)
+    xip_ctrl_hw->ctr_hit = 0;
+    xip_ctrl_hw->ctr_acc = 0;
+}
+
+void __render_func(telemetry_line)(uint32_t us) {
+    if(us > line_max) {
+        line_max = us;
+    }
+    line_total += us;
+    line_count++;
+}
+
+void __render_func(telemetry_queue)(int32_t lead) {
+    if(lead < queue_min) {
+        queue_min = lead;
+    }
+    if(lead <= 0) {
+        late_lines++;
+    }
+}
+
+void telemetry_end_frame(void) {
+    if(!line_count) {
+        return;
+    }
+
+    uint32_t budget = render_stats.line_budget_us;
+    render_stats.line_max_us = line_max;
+    render_stats.line_avg_us = line_total / line_count;
+    render_stats.headroom_pct = (line_max >= budget) ? 0 : 100 - line_max * 100 / budget;
+    render_stats.queue_min = queue_min;
+    render_stats.late_lines = late_lines;
+
+    uint32_t hits = xip_ctrl_hw->ctr_hit;
+    uint32_t accesses = xip_ctrl_hw->ctr_acc;
+    xip_ctrl_hw->ctr_hit = 0;
+    xip_ctrl_hw->ctr_acc = 0;
+    render_stats.xip_misses = accesses - hits;
+    render_stats.xip_hit_pct = accesses ? 100 - (uint64_t)(accesses - hits) * 100 / accesses : 100;
+    render_stats.frame++;
+
+    line_max = 0;
+    line_total = 0;
+    line_count = 0;
+    queue_min = render_stats.queue_depth;
+    late_lines = 0;
+}
@@ -0,0 +1,36 @@
+// Render timing measured on core 1 and published once per frame
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include "pico.h"
+
+typedef struct {
+    uint32_t frame;          // Frames measured so far
+    uint32_t line_budget_us; // Time available to render one generated line
+    uint32_t line_max_us;    // Slowest line in the last frame
+    uint32_t line_avg_us;    // Average line in the last frame
+    uint8_t headroom_pct;    // 100 - slowest line as a percentage of the budget
+    uint8_t queue_depth;     // Scanline buffers core 1 can fill ahead of the display
+    int16_t queue_min;       // Fewest lines ahead of the display any line was started in the last frame
+    uint16_t late_lines;     // Lines started too late to be shown in the last frame
+    uint8_t xip_hit_pct;     // XIP cache hits as a percentage of accesses in the last frame (both cores)
+    uint32_t xip_misses;     // XIP cache misses in the last frame (both cores)
+} render_stats_t;
+
+// Last completed frame's stats (read from any core)
+extern volatile render_stats_t render_stats;
+
+// Work out the line budget for the current video mode
+void telemetry_init(void);
+
+// Record the time taken to render one line (core 1)
+void telemetry_line(uint32_t us);
+
+// Record how many lines ahead of the display a line was started (core 1)
+void telemetry_queue(int32_t lead);
+
+// Publish the stats gathered since the last call (core 1, at frame boundary)
+void telemetry_end_frame(void);
+
+#endif
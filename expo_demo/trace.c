@@ -0,0 +1,104 @@
+#include "trace.h"
+
+#define POT_MASK 0xfff
+#define REPEAT_SHIFT 24
+#define MAX_REPEAT 0xff
+
+static trace_entry_t pack(const uint16_t pot[2]) {
+    return (pot[0] & POT_MASK) | (pot[1] & POT_MASK) << 12;
+}
+
+void trace_clear(trace_t *trace) {
+    trace->count = 0;
+    trace_rewind(trace);
+}
+
+bool trace_record(trace_t *trace, const uint16_t pot[2]) {
+    trace_entry_t entry = pack(pot);
+
+    // Extend the last entry if the readings are unchanged
+    if(trace->count) {
+        trace_entry_t *last = &trace->entries[trace->count - 1];
+        if((*last & ((1u << REPEAT_SHIFT) - 1)) == entry && (*last >> REPEAT_SHIFT) < MAX_REPEAT) {
+            *last += 1u << REPEAT_SHIFT;
+            return true;
+        }
+    }
+    if(trace->count == TRACE_MAX_ENTRIES) {
+        return false;
+    }
+    trace->entries[trace->count++] = entry;
+    return true;
+}
+
+void trace_rewind(trace_t *trace) {
+    trace->index = 0;
+    trace->repeat = 0;
+}
+
+bool trace_replay(trace_t *trace, uint16_t pot[2]) {
+    if(!trace->count) {
+        return false;
+    }
+    if(trace->index >= trace->count) {
+        trace_rewind(trace);
+    }
+
+    trace_entry_t entry = trace->entries[trace->index];
+    pot[0] = entry & POT_MASK;
+    pot[1] = (entry >> 12) & POT_MASK;
+
+    if(trace->repeat == entry >> REPEAT_SHIFT) {
+        trace->index++;
+        trace->repeat = 0;
+    } else {
+        trace->repeat++;
+    }
+    return true;
+}
+
+void trace_write(const trace_t *trace, void (*put)(uint8_t c)) {
+    put('C');
+    put('B');
+    put('T');
+    put(trace->count & 0xff);
+    put(trace->count >> 8);
+
+    uint8_t sum = 0;
+    for(uint16_t n = 0; n < trace->count; n++) {
+        trace_entry_t entry = trace->entries[n];
+        for(int shift = 0; shift < 32; shift += 8) {
+            uint8_t c = entry >> shift;
+            put(c);
+            sum += c;
+        }
+    }
+    put(sum);
+}
+
+bool trace_read(trace_t *trace, const uint8_t *data, size_t len) {
+    if(len < TRACE_HEADER_BYTES + 1 || data[0] != 'C' || data[1] != 'B' || data[2] != 'T') {
+        return false;
+    }
+    uint16_t count = data[3] | data[4] << 8;
+    if(count > TRACE_MAX_ENTRIES || len != TRACE_HEADER_BYTES + 4 * (size_t)count + 1) {
+        return false;
+    }
+
+    const uint8_t *p = data + TRACE_HEADER_BYTES;
+    uint8_t sum = 0;
+    for(size_t n = 0; n < 4 * (size_t)count; n++) {
+        sum += p[n];
+    }
+    if(sum != p[4 * count]) {
+        return false;
+    }
+
+    for(uint16_t n = 0; n < count; n++) {
+        trace->entries[n] = p[0] | p[1] << 8 | p[2] << 16 | (trace_entry_t)p[3] << 24;
+        p += 4;
+    }
+    trace->count = count;
+    trace_rewind(trace);
+    return true;
+}
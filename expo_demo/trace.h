@@ -0,0 +1,65 @@
+// Pot input trace
+//
+// While recording, core 0 logs the raw pot readings once per frame. While
+// replaying, the logged readings are fed through the pot mapping in place of
+// adc_read, one entry per frame, so the same gesture (and the same worst-case
+// parameters) can be rendered again on the board or by host/render.
+//
+// Each entry holds both 12-bit readings and a repeat count, so a pot that is
+// held still costs one entry per 256 frames.
+//
+// Stream format (little endian):
+// 'C' 'B' 'T' | entry count (2 bytes) | count x entry (4 bytes) | 8-bit sum of the entries
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Values of PARAM_TRACE
+enum {
+    TRACE_OFF,
+    TRACE_RECORD, // Log pot readings, the trace is written to USB when recording stops
+    TRACE_REPLAY, // Loop the trace in place of the pots
+    TRACE_MODE_COUNT
+};
+
+// 16 KiB of entries, at least 68 s of constantly moving pots at 60 Hz
+#define TRACE_MAX_ENTRIES 4096
+
+#define TRACE_HEADER_BYTES 5
+#define TRACE_MAX_BYTES (TRACE_HEADER_BYTES + 4 * TRACE_MAX_ENTRIES + 1)
+
+// Bits 0-11 pot 0, bits 12-23 pot 1, bits 24-31 number of frames - 1
+typedef uint32_t trace_entry_t;
+
+typedef struct {
+    uint16_t count;
+    trace_entry_t entries[TRACE_MAX_ENTRIES];
+    // Replay position
+    uint16_t index;
+    uint8_t repeat;
+} trace_t;
+
+// Empty the trace
+void trace_clear(trace_t *trace);
+
+// Append one frame of readings, returns false if the trace is full
+bool trace_record(trace_t *trace, const uint16_t pot[2]);
+
+// Start replaying from the first frame
+void trace_rewind(trace_t *trace);
+
+// Readings for the next frame of the replay (loops at the end)
+// Returns false if the trace is empty
+bool trace_replay(trace_t *trace, uint16_t pot[2]);
+
+// Serialize the trace one byte at a time
+void trace_write(const trace_t *trace, void (*put)(uint8_t c));
+
+// Load a serialized trace, returns false if it is malformed
+bool trace_read(trace_t *trace, const uint8_t *data, size_t len);
+
+#endif
@@ -0,0 +1,14 @@
+#include "trig.h"
+#include "persist.h"
+#include <math.h>
+
+int16_t trig_sin[256];
+
+void trig_init(void) {
+    if(persist_table(PERSIST_TABLE_SINE, trig_sin, sizeof(trig_sin))) {
+        return;
+    }
+    for(uint i = 0; i < 256; i++) {
+        trig_sin[i] = (int16_t)(sinf(i * 2 * (float)M_PI / 256) * TRIG_ONE);
+    }
+}
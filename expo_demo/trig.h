@@ -0,0 +1,27 @@
+// Shared sine table
+//
+// One full turn of sine in 256 steps, Q14, for everything that turns angles
+// into offsets: the solids' rotation, the wobble and copper waves and the
+// modulation LFOs. Built once at start-up, or copied from flash with the other
+// generated tables (see persist.h).
+
+#ifndef TRIG_H
+#define TRIG_H
+
+#include "pico.h"
+
+// Value of 1 in trig_sin
+#define TRIG_ONE 16384
+
+// sin(2 pi n / 256) * TRIG_ONE
+extern int16_t trig_sin[256];
+
+// Build or load the table (core 0, before effects_init and modulation_poll)
+void trig_init(void);
+
+// Cosine of an angle in 256ths of a turn
+static inline int16_t trig_cos(uint8_t angle) {
+    return trig_sin[(uint8_t)(angle + 64)];
+}
+
+#endif
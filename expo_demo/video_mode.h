@@ -0,0 +1,21 @@
+// Video mode shared by every expo_demo source file
+
+#ifndef VIDEO_MODE_H
+#define VIDEO_MODE_H
+
+#include "pico/scanvideo.h"
+
+// VGA mode struct defines video timing and size
+// (can be overridden from the build with VGA_MODE, which also sizes the
+// scanline buffers for the mode, see CMakeLists.txt)
+
+#ifndef vga_mode
+//#define vga_mode vga_mode_640x480_60
+//#define vga_mode vga_mode_320x240_60
+//#define vga_mode vga_mode_213x160_60
+#define vga_mode vga_mode_160x120_60
+//#define vga_mode vga_mode_tft_800x480_50
+//#define vga_mode vga_mode_tft_400x240_50
+#endif
+
+#endif
@@ -0,0 +1,220 @@
+#include "wall.h"
+#include "params.h"
+#include "control.h"
+#include "video_mode.h"
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+#include "hardware/uart.h"
+
+// Sync line: the leader's UART TX drives the RX of every follower
+#define SYNC_UART uart1
+#define SYNC_TX_PIN 20
+#define SYNC_RX_PIN 21
+#define SYNC_BAUD 1000000
+
+// A sync message is a start byte, the 16-bit frame number (low byte first),
+// the leader's two 12-bit pot readings in 3 bytes, a count of parameter
+// updates, 3 bytes (ID, then value low byte first) for each update, and a check
+// byte (XOR of the rest). 80 us on the line with no updates, and the whole
+// message fits the 32-byte TX FIFO with up to 8
+#define SYNC_START 0xa5
+#define SYNC_HEADER_BYTES 7
+#define SYNC_UPDATE_BYTES 3
+#define SYNC_MAX_BYTES (SYNC_HEADER_BYTES + SYNC_UPDATE_BYTES * PARAM_COUNT + 1)
+
+// Parameters each board keeps to itself: its place on the wall, and pot traces
+// and scene saving, which act on the board they are sent to
+#define LOCAL_PARAMS                                                                                  \
+    ((1u << PARAM_WALL_COLUMNS) | (1u << PARAM_WALL_ROWS) | (1u << PARAM_WALL_TILE) | (1u << PARAM_TRACE) | \
+     (1u << PARAM_SAVE_SCENE))
+
+// Frames a follower holds without hearing the leader before running on its own
+#define LOST_FRAMES 3
+
+// How long a follower waits for the leader before starting video anyway
+#define START_TIMEOUT_US 2000000
+
+uint16_t wall_width, wall_height;
+uint16_t wall_x0, wall_y0;
+volatile uint32_t wall_frame;
+
+// More than one screen, and this board sends the sync
+static bool tiled;
+static bool leader;
+// Video has started (calibration draws frames before, as a board on its own)
+static bool started;
+
+// Frame number on the leader's count (core 1)
+static uint16_t frame;
+// Frames since a follower last heard the leader
+static uint8_t unheard;
+
+// Leader's pot readings as of the last frame (core 1)
+static volatile uint16_t pots[2];
+// Next parameter the leader resends (core 1)
+static uint8_t resend_id;
+
+// Message being received
+static uint8_t message[SYNC_MAX_BYTES];
+static uint8_t message_len;
+
+void wall_init(void) {
+    uint columns = param(PARAM_WALL_COLUMNS);
+    uint rows = param(PARAM_WALL_ROWS);
+    uint tile = MIN(param(PARAM_WALL_TILE), columns * rows - 1);
+
+    wall_width = vga_mode.width * columns;
+    wall_height = vga_mode.height * rows;
+    wall_x0 = tile % columns * vga_mode.width;
+    wall_y0 = tile / columns * vga_mode.height;
+    wall_frame = 0;
+
+    tiled = columns * rows > 1;
+    leader = tile == 0;
+    started = false;
+    frame = 0;
+    unheard = 0;
+    resend_id = 0;
+    message_len = 0;
+    if(!tiled) {
+        return;
+    }
+
+    uart_init(SYNC_UART, SYNC_BAUD);
+    gpio_set_function(leader ? SYNC_TX_PIN : SYNC_RX_PIN, GPIO_FUNC_UART);
+}
+
+void wall_start(void) {
+    if(!tiled || leader) {
+        return;
+    }
+    // The message is left for the first wall_begin_frame
+    uint64_t start = time_us_64();
+    while(!uart_is_readable(SYNC_UART) && time_us_64() - start < START_TIMEOUT_US) {
+    }
+}
+
+bool wall_following(void) {
+    return tiled && !leader;
+}
+
+uint16_t wall_pot(uint n) {
+    return (tiled && started) ? pots[n] : control_pot(n);
+}
+
+static uint8_t check_byte(const uint8_t *bytes, uint len) {
+    uint8_t check = 0;
+    for(uint n = 0; n < len; n++) {
+        check ^= bytes[n];
+    }
+    return check;
+}
+
+// Pick up a whole message from the leader: its pots, and its parameter updates
+// staged to apply with this frame
+static void take_message(uint len) {
+    pots[0] = message[3] | (message[4] & 0x0f) << 8;
+    pots[1] = message[4] >> 4 | message[5] << 4;
+
+    param_update_t updates[PARAM_COUNT];
+    uint count = 0;
+    for(uint n = SYNC_HEADER_BYTES; n + 1 < len; n += SYNC_UPDATE_BYTES) {
+        uint8_t id = message[n];
+        if(id < PARAM_COUNT && !(LOCAL_PARAMS & (1u << id))) {
+            updates[count++] = (param_update_t){id, message[n + 1] | message[n + 2] << 8};
+        }
+    }
+    params_stage(updates, count);
+}
+
+// Newest frame number heard since the last call, returns false if none
+static bool receive(uint16_t *n) {
+    bool heard = false;
+    while(uart_is_readable(SYNC_UART)) {
+        uint8_t c = uart_getc(SYNC_UART);
+        // Anything but a start byte between messages is noise
+        if(!message_len && c != SYNC_START) {
+            continue;
+        }
+        message[message_len++] = c;
+        if(message_len < SYNC_HEADER_BYTES) {
+            continue;
+        }
+        uint8_t count = message[SYNC_HEADER_BYTES - 1];
+        if(count > PARAM_COUNT) {
+            message_len = 0;
+            continue;
+        }
+        uint len = SYNC_HEADER_BYTES + SYNC_UPDATE_BYTES * count + 1;
+        if(message_len < len) {
+            continue;
+        }
+        message_len = 0;
+        if(check_byte(message, len - 1) == message[len - 1]) {
+            *n = message[1] | message[2] << 8;
+            take_message(len);
+            heard = true;
+        }
+    }
+    return heard;
+}
+
+uint wall_begin_frame(bool first) {
+    uint steps = first ? 0 : 1;
+    started |= first;
+
+    if(started && tiled && leader) {
+        frame += steps;
+    } else if(started && tiled) {
+        uint16_t heard;
+        if(receive(&heard)) {
+            // As many steps as the leader has moved on (none if it hasn't
+            // started a new frame, or this board ran ahead while it was lost)
+            uint16_t behind = heard - frame;
+            steps = (first || behind >= 0x8000) ? 0 : MIN(behind, WALL_MAX_STEPS);
+            frame = heard;
+            unheard = 0;
+        } else if(unheard < LOST_FRAMES) {
+            unheard++;
+            steps = 0;
+        } else {
+            frame += steps;
+        }
+    }
+
+    wall_frame += steps;
+    return steps;
+}
+
+void wall_send_frame(uint32_t changed, bool first) {
+    if(!started || !tiled || !leader) {
+        return;
+    }
+
+    // Everything on the first frame, so the followers start from the leader's
+    // scene, and one more parameter in turn every frame, so a follower that
+    // missed a message catches up
+    if(first) {
+        changed = 0xffffffff;
+    }
+    changed |= 1u << resend_id;
+    resend_id = (resend_id + 1) % PARAM_COUNT;
+    changed &= ~LOCAL_PARAMS & ((1ull << PARAM_COUNT) - 1);
+
+    pots[0] = control_pot(0);
+    pots[1] = control_pot(1);
+    uint8_t bytes[SYNC_MAX_BYTES] = {SYNC_START, frame & 0xff, frame >> 8, pots[0] & 0xff,
+                                     (pots[0] >> 8) | (pots[1] & 0x0f) << 4, pots[1] >> 4, 0};
+    uint len = SYNC_HEADER_BYTES;
+    for(uint id = 0; changed; id++, changed >>= 1) {
+        if(changed & 1u) {
+            uint16_t value = params_base(id);
+            bytes[len++] = id;
+            bytes[len++] = value & 0xff;
+            bytes[len++] = value >> 8;
+            bytes[SYNC_HEADER_BYTES - 1]++;
+        }
+    }
+    bytes[len] = check_byte(bytes, len);
+    uart_write_blocking(SYNC_UART, bytes, len + 1);
+}
@@ -0,0 +1,81 @@
+// Video walls: several boards showing one picture
+//
+// The wall is a canvas of PARAM_WALL_COLUMNS x PARAM_WALL_ROWS screens, and
+// each board draws the tile of it set by PARAM_WALL_TILE. Every board runs the
+// same effects with the same parameters, and the effects draw in canvas
+// coordinates (centered on the canvas, sized to it), so the picture carries on
+// across the edges of the screens.
+//
+// Tile 0 leads. At the start of each frame it sends its frame number on a
+// sync line (UART TX on GPIO 20, wired to GPIO 21 on every other board), and
+// the followers step their animation by the leader's frames instead of their
+// own: a follower whose display runs slightly fast holds a frame when no new
+// number has arrived, and one that runs slow takes two steps. The animation
+// stays on the leader's frame however far the crystals drift, and a follower
+// that stops hearing the leader carries on by itself. Followers also hold back
+// starting video until the leader's first frame, so the screens start
+// together; boards should be powered up together, since a follower restarted
+// on its own rejoins the frame clock but not the animation.
+//
+// Parameters are set on the leader, by its pots or over its USB. With each
+// frame number it sends the parameters that changed that frame (all of them
+// on the first frame, and one more in turn every frame in case a follower
+// missed one) and its two pot readings, and the followers apply them with the
+// same frame. Followers ignore their own pots, and the pot sources of
+// modulation read the leader's pots. A follower still takes USB updates, but
+// the leader's values overwrite them. The wall layout, pot traces and scene
+// saving stay local to each board. More than 8 changes in one frame (loading a
+// scene) hold up core 1 for up to a millisecond while they are sent.
+//
+// The wall size and tile are read once at power-on (set them over USB, save
+// the scene and restart). With a 1x1 wall the board is on its own, the canvas
+// is its screen and the sync line is not used.
+
+#ifndef WALL_H
+#define WALL_H
+
+#include "pico.h"
+
+// Largest wall in screens across or down
+#define WALL_MAX_SIZE 4
+
+// Most animation steps taken in one frame to catch up with the leader
+#define WALL_MAX_STEPS 4
+
+// Canvas size, and the position of this board's screen on it, in pixels
+extern uint16_t wall_width, wall_height;
+extern uint16_t wall_x0, wall_y0;
+
+// Animation frames so far, for effects stepped on core 0 to take one step per
+// frame of the wall (written by core 1, moving on by up to WALL_MAX_STEPS
+// a frame when a follower catches up, see handoff.h)
+extern volatile uint32_t wall_frame;
+
+// Work out the canvas and set up the sync line (core 0, after the saved scene
+// is loaded and before effects_init)
+void wall_init(void);
+
+// Wait for the leader's first frame, or up to two seconds (core 1, just before
+// starting video; returns straight away on the leader or a board on its own)
+void wall_start(void);
+
+// Receive the frame sync and return how many animation steps to take this
+// frame, staging any parameters the leader sent with it (core 1, at frame
+// boundary before params_apply_pending; always 0 for the first frame and 1 for
+// the leader or a board on its own). Until the first frame of video the board
+// runs on its own, so calibration doesn't talk to the other boards
+uint wall_begin_frame(bool first);
+
+// Send the frame sync with the parameters in changed, as returned by
+// params_apply_pending (core 1, at frame boundary after params_apply_pending;
+// does nothing but on the leader of a wall)
+void wall_send_frame(uint32_t changed, bool first);
+
+// Whether this board follows another's frames and parameters
+bool wall_following(void);
+
+// Raw reading (0-4095) of pot n on the leader, as of its last frame, or this
+// board's own if it is on its own (for pot modulation, core 0)
+uint16_t wall_pot(uint n);
+
+#endif
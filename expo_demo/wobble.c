@@ -0,0 +1,169 @@
+#include "wobble.h"
+#include "span.h"
+#include "params.h"
+#include "video_mode.h"
+#include "wall.h"
+#include "trig.h"
+#include "placement.h"
+
+// Lines covered by the table (taller modes leave the bottom still)
+#define WOBBLE_MAX_LINES 480
+
+static wobble_line_t table[WOBBLE_MAX_LINES];
+static uint16_t lines;
+static bool active;
+
+// Steps of trig_sin per line for two waves down the screen (8.8), and lines
+// per band of WOBBLE_SPLIT
+static uint16_t wave_step;
+static uint16_t band_lines;
+
+// Animation position, 8.8 steps of trig_sin
+static uint16_t phase;
+
+void wobble_init(void) {
+    lines = MIN(vga_mode.height, WOBBLE_MAX_LINES);
+    wave_step = (512 << 8) / vga_mode.height;
+    band_lines = MAX(vga_mode.height / 8, 1);
+    phase = 0;
+    active = false;
+}
+
+// Random shift in -depth to depth for canvas line y, new each animation frame
+// (the same on every board of a video wall)
+static int16_t noise_shift(uint32_t y, int32_t depth) {
+    uint32_t h = (y + 1) * 0x9e3779b1u ^ wall_frame * 0x85ebca6bu;
+    h ^= h >> 15;
+    h *= 0x2c1b3c6du;
+    h ^= h >> 12;
+    return (int16_t)(((h >> 16) * (2 * depth + 1) >> 16) - depth);
+}
+
+void wobble_begin_frame(uint steps) {
+    phase += steps * param(PARAM_SPEED_INC) << 8;
+
+    uint8_t mode = param(PARAM_WOBBLE);
+    int32_t depth = param(PARAM_WOBBLE_DEPTH);
+    active = mode != WOBBLE_OFF && depth;
+    if(!active) {
+        return;
+    }
+
+    uint8_t turn = phase >> 8;
+    int32_t swing = depth * trig_sin[turn] >> 14;
+    for(uint n = 0; n < lines; n++) {
+        // Canvas line, so the shape carries on across a video wall
+        uint32_t y = wall_y0 + n;
+        uint8_t angle = (y * wave_step >> 8) - turn;
+        wobble_line_t *w = &table[n];
+        w->shift = 0;
+        w->scale = WOBBLE_ONE;
+        switch(mode) {
+            case WOBBLE_WAVE:
+                w->shift = depth * trig_sin[angle] >> 14;
+                break;
+            case WOBBLE_SPLIT:
+                w->shift = ((y / band_lines) & 1) ? swing : -swing;
+                break;
+            case WOBBLE_NOISE:
+                w->shift = noise_shift(y, depth);
+                break;
+            case WOBBLE_BULGE:
+                // Only ever wider, so the source never needs more than a line
+                w->scale = WOBBLE_ONE + (depth * (trig_sin[angle] + TRIG_ONE) >> 13);
+                break;
+        }
+    }
+}
+
+wobble_line_t __render_func(wobble_line)(uint16_t y) {
+    if(!active || y >= lines) {
+        return (wobble_line_t){0, WOBBLE_ONE};
+    }
+    return table[y];
+}
+
+// Where source pixel s lands in an area stretched about c
+static inline int32_t dest_x(wobble_line_t w, int32_t c, int32_t s) {
+    return c + w.shift + (((s - c) * w.scale) >> 8);
+}
+
+// Source pixel shown at x, to within a pixel
+static inline int32_t source_x(wobble_line_t w, int32_t c, int32_t x) {
+    return c + (x - w.shift - c) * WOBBLE_ONE / w.scale;
+}
+
+void __render_func(wobble_source)(wobble_line_t w, uint16_t lo, uint16_t hi, uint16_t x0, uint16_t x1,
+                                  uint16_t *s0, uint16_t *s1) {
+    int32_t c = (lo + hi) / 2;
+    // A pixel either side covers the rounding of source_x
+    int32_t first = MAX(source_x(w, c, x0) - 1, lo);
+    int32_t end = MIN(source_x(w, c, x1) + 2, hi);
+    *s0 = first;
+    *s1 = MAX(end, first);
+}
+
+// Write len pixels of the token at t from its pixel n0 on
+static uint16_t *__render_func(shift_token)(uint16_t *p, const uint16_t *t, uint16_t n0, uint16_t len) {
+    if(t[0] == COMPOSABLE_COLOR_RUN) {
+        return span_color(p, t[1], len);
+    }
+    uint16_t *first = p + 1;
+    p = span_raw_begin(p, len);
+    *first = span_token_pixel(t, n0);
+    for(uint n = 1; n < len; n++) {
+        *p++ = span_token_pixel(t, n0 + n);
+    }
+    return p;
+}
+
+// Write len pixels from x of the token at t, which starts at source pixel s
+// and is stretched by w about c
+static uint16_t *__render_func(stretch_token)(uint16_t *p, const uint16_t *t, wobble_line_t w, int32_t c, int32_t s,
+                                              int32_t x, uint16_t len) {
+    if(t[0] == COMPOSABLE_COLOR_RUN) {
+        return span_color(p, t[1], len);
+    }
+
+    // Source position of the middle of each pixel relative to c (16.16),
+    // clamped to the token where it rounds just outside
+    int32_t pos = (int32_t)((int64_t)(2 * (x - w.shift - c) + 1) * (1 << 23) / w.scale);
+    int32_t step = (1 << 24) / w.scale;
+    int32_t last = span_token_pixels(t) - 1;
+    int32_t n0 = MIN(MAX(c + (pos >> 16) - s, 0), last);
+
+    uint16_t *first = p + 1;
+    p = span_raw_begin(p, len);
+    *first = span_token_pixel(t, n0);
+    for(uint n = 1; n < len; n++) {
+        pos += step;
+        *p++ = span_token_pixel(t, MIN(MAX(c + (pos >> 16) - s, 0), last));
+    }
+    return p;
+}
+
+uint16_t *__render_func(wobble_tokens)(uint16_t *p, wobble_line_t w, uint16_t lo, uint16_t hi, const uint16_t *src,
+                                       const uint16_t *end, uint16_t s0, uint16_t x0, uint16_t x1) {
+    int32_t c = (lo + hi) / 2;
+    int32_t x = x0;
+    int32_t s = s0;
+    for(const uint16_t *t = src; t < end && x < x1; t += span_token_size(t)) {
+        uint16_t len = span_token_pixels(t);
+        // Tokens land end to end, so only the first can leave a gap (where
+        // the source is off the left of the area)
+        int32_t a = MAX(dest_x(w, c, s), x);
+        int32_t b = MIN(dest_x(w, c, s + len), x1);
+        if(a < b) {
+            p = span_color(p, 0, a - x);
+            if(w.scale == WOBBLE_ONE) {
+                p = shift_token(p, t, a - w.shift - s, b - a);
+            } else {
+                p = stretch_token(p, t, w, c, s, a, b - a);
+            }
+            x = b;
+        }
+        s += len;
+    }
+    // Black where the source is off the right of the area
+    return span_color(p, 0, x1 - x);
+}
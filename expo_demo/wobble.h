@@ -0,0 +1,72 @@
+// Raster wobble: per-line horizontal displacement and stretch
+//
+// A stage between the effects and the scanline buffer. At each frame
+// boundary a table gives every line a horizontal shift and a scale, from one
+// of the shapes below. A line that moves has its effect drawn into scratch
+// first; its tokens are then copied out at their new places, so a run only
+// changes where it starts and how long it is, and only runs cut by the edges
+// of the area are split. Raw runs take a pixel copy (resampled when
+// stretched). Pixels whose source falls outside the area are black. Any
+// effect can wobble without being changed, and lines that stay put are drawn
+// straight into the buffer as before.
+//
+// The depth is a parameter, so modulation can drive it from the pots or an
+// envelope as well as setting it by hand.
+
+#ifndef WOBBLE_H
+#define WOBBLE_H
+
+#include "pico.h"
+
+// Values of PARAM_WOBBLE
+enum {
+    WOBBLE_OFF,
+    WOBBLE_WAVE,  // Two sine waves down the screen, rolling downwards
+    WOBBLE_SPLIT, // Bands of lines swinging alternately left and right
+    WOBBLE_NOISE, // Every line jumps to a new random shift each frame
+    WOBBLE_BULGE, // Lines stretched about the middle by a wave rolling downwards
+    WOBBLE_COUNT
+};
+
+// Largest PARAM_WOBBLE_DEPTH, in pixels of shift (for WOBBLE_BULGE, in 1/64ths
+// of the width added to the widest lines)
+#define WOBBLE_MAX_DEPTH 64
+
+// Scale of a line that is not stretched (8.8, scales are never below this, so
+// a line's source is never wider than the line)
+#define WOBBLE_ONE 256
+
+// Displacement of one line: pixel x of the area shows the pixel that was
+// shift pixels to its left, with the area stretched by scale about its middle
+typedef struct {
+    int16_t shift;
+    uint16_t scale;
+} wobble_line_t;
+
+// Size the line table and steps to the video mode and reset the phase (call
+// once before drawing)
+void wobble_init(void);
+
+// Fill in the displacement of each line for this frame, moving the shape on
+// by steps animation steps (core 1, at frame boundary)
+void wobble_begin_frame(uint steps);
+
+// Displacement of screen line y
+wobble_line_t wobble_line(uint16_t y);
+
+// Whether a line is displaced at all
+static inline bool wobble_moves(wobble_line_t w) {
+    return w.shift || w.scale != WOBBLE_ONE;
+}
+
+// Source pixels s0 to s1 (exclusive) needed to draw pixels x0 to x1 of an area
+// covering lo to hi (s0 >= s1 if all of them fall outside the area)
+void wobble_source(wobble_line_t w, uint16_t lo, uint16_t hi, uint16_t x0, uint16_t x1, uint16_t *s0,
+                   uint16_t *s1);
+
+// Write pixels x0 to x1 of an area covering lo to hi, displaced by w, from the
+// tokens src to end holding the area's source pixels from s0 on
+uint16_t *wobble_tokens(uint16_t *p, wobble_line_t w, uint16_t lo, uint16_t hi, const uint16_t *src,
+                        const uint16_t *end, uint16_t s0, uint16_t x0, uint16_t x1);
+
+#endif
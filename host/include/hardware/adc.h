@@ -0,0 +1,29 @@
+// Host stand-in for hardware/adc.h
+// Reads return whatever the host program last stored in host_adc_value.
+
+#ifndef HOST_HARDWARE_ADC_H
+#define HOST_HARDWARE_ADC_H
+
+#include "pico.h"
+
+#define HOST_ADC_INPUTS 5
+
+extern uint16_t host_adc_value[HOST_ADC_INPUTS];
+extern uint host_adc_input;
+
+static inline void adc_init(void) {
+}
+
+static inline void adc_gpio_init(uint gpio) {
+    (void)gpio;
+}
+
+static inline void adc_select_input(uint input) {
+    host_adc_input = input;
+}
+
+static inline uint16_t adc_read(void) {
+    return host_adc_value[host_adc_input];
+}
+
+#endif
@@ -0,0 +1,18 @@
+// Host stand-in for hardware/flash.h
+// Offsets are into host_flash, which reads back through XIP_BASE as on the board.
+
+#ifndef HOST_HARDWARE_FLASH_H
+#define HOST_HARDWARE_FLASH_H
+
+#include "pico.h"
+
+#define FLASH_PAGE_SIZE 256
+#define FLASH_SECTOR_SIZE 4096
+
+// Set whole sectors to 0xff
+void flash_range_erase(uint32_t flash_offs, size_t count);
+
+// Program whole pages (like NOR flash, bits can only be cleared)
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count);
+
+#endif
@@ -0,0 +1,22 @@
+// Host stand-in for hardware/gpio.h
+// There are no pins on the host, so pin functions are ignored.
+
+#ifndef HOST_HARDWARE_GPIO_H
+#define HOST_HARDWARE_GPIO_H
+
+#include "pico.h"
+
+enum gpio_function {
+    GPIO_FUNC_SPI = 1,
+    GPIO_FUNC_UART = 2,
+    GPIO_FUNC_I2C = 3,
+    GPIO_FUNC_PWM = 4,
+    GPIO_FUNC_SIO = 5,
+};
+
+static inline void gpio_set_function(uint gpio, enum gpio_function fn) {
+    (void)gpio;
+    (void)fn;
+}
+
+#endif
@@ -0,0 +1,23 @@
+// Host stand-in for hardware/structs/xip_ctrl.h
+// Code runs from host memory, so the cache counters never move and read 0.
+
+#ifndef HOST_HARDWARE_STRUCTS_XIP_CTRL_H
+#define HOST_HARDWARE_STRUCTS_XIP_CTRL_H
+
+#include "pico.h"
+
+typedef struct {
+    volatile uint32_t ctrl;
+    volatile uint32_t flush;
+    volatile uint32_t stat;
+    volatile uint32_t ctr_hit;
+    volatile uint32_t ctr_acc;
+    volatile uint32_t stream_addr;
+    volatile uint32_t stream_ctr;
+    volatile uint32_t stream_fifo;
+} xip_ctrl_hw_t;
+
+extern xip_ctrl_hw_t host_xip_ctrl;
+#define xip_ctrl_hw (&host_xip_ctrl)
+
+#endif
@@ -0,0 +1,29 @@
+// Host stand-in for hardware/uart.h
+// Bytes written go to host_uart_tx (if the host program sets it), and reads
+// take the bytes the host program has passed to host_uart_receive.
+
+#ifndef HOST_HARDWARE_UART_H
+#define HOST_HARDWARE_UART_H
+
+#include "pico.h"
+
+typedef struct {
+    uint8_t index;
+} uart_inst_t;
+
+extern uart_inst_t host_uarts[2];
+#define uart0 (&host_uarts[0])
+#define uart1 (&host_uarts[1])
+
+// Called with each byte written to a UART
+extern void (*host_uart_tx)(uart_inst_t *uart, uint8_t c);
+
+// Queue a byte to be read from a UART
+void host_uart_receive(uart_inst_t *uart, uint8_t c);
+
+uint uart_init(uart_inst_t *uart, uint baudrate);
+void uart_write_blocking(uart_inst_t *uart, const uint8_t *src, size_t len);
+bool uart_is_readable(uart_inst_t *uart);
+char uart_getc(uart_inst_t *uart);
+
+#endif
@@ -0,0 +1,45 @@
+// Host stand-in for the Pico SDK base header
+// Only what the expo_demo sources use is provided.
+
+#ifndef HOST_PICO_H
+#define HOST_PICO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <assert.h>
+
+typedef unsigned int uint;
+
+#define count_of(a) (sizeof(a) / sizeof((a)[0]))
+
+#ifndef MIN
+#define MIN(a, b) ((b) > (a) ? (a) : (b))
+#endif
+#ifndef MAX
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#endif
+
+// Code and data placement attributes have no effect on the host
+#define __not_in_flash_func(func_name) func_name
+#define __time_critical_func(func_name) func_name
+#define __scratch_x(group)
+#define __scratch_y(group)
+#define __not_in_flash(group)
+#define __in_flash(group)
+#define __aligned(n) __attribute__((aligned(n)))
+#define __force_inline inline __attribute__((always_inline))
+#define __noinline __attribute__((noinline))
+#ifndef __unused
+#define __unused __attribute__((unused))
+#endif
+
+#define PICO_OK 0
+#define PICO_ERROR_TIMEOUT -1
+
+// Flash is simulated in RAM (see hardware/flash.h), blank at start-up
+#define PICO_FLASH_SIZE_BYTES (2 * 1024 * 1024)
+extern uint8_t host_flash[PICO_FLASH_SIZE_BYTES];
+#define XIP_BASE ((uintptr_t)host_flash)
+
+#endif
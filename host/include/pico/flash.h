@@ -0,0 +1,19 @@
+// Host stand-in for pico/flash.h
+// There is no other core to lock out, so func just runs.
+
+#ifndef HOST_PICO_FLASH_H
+#define HOST_PICO_FLASH_H
+
+#include "pico.h"
+
+static inline bool flash_safe_execute_core_init(void) {
+    return true;
+}
+
+static inline int flash_safe_execute(void (*func)(void *), void *param, uint32_t enter_exit_timeout_ms) {
+    (void)enter_exit_timeout_ms;
+    func(param);
+    return PICO_OK;
+}
+
+#endif
@@ -0,0 +1,93 @@
+// Host stand-in for pico/scanvideo.h
+// Mode and scanline buffer types match pico_scanvideo so effect code builds
+// unchanged. Lines are turned into pixels by scanvideo_host.c.
+
+#ifndef HOST_PICO_SCANVIDEO_H
+#define HOST_PICO_SCANVIDEO_H
+
+#include "pico.h"
+
+#ifndef PICO_SCANVIDEO_MAX_SCANLINE_BUFFER_WORDS
+#define PICO_SCANVIDEO_MAX_SCANLINE_BUFFER_WORDS 180
+#endif
+
+#ifndef PICO_SCANVIDEO_SCANLINE_BUFFER_COUNT
+#define PICO_SCANVIDEO_SCANLINE_BUFFER_COUNT 8
+#endif
+
+#define PICO_SCANVIDEO_PIXEL_RSHIFT 0u
+#define PICO_SCANVIDEO_PIXEL_GSHIFT 6u
+#define PICO_SCANVIDEO_PIXEL_BSHIFT 11u
+#define PICO_SCANVIDEO_ALPHA_PIN 5u
+
+#define PICO_SCANVIDEO_PIXEL_FROM_RGB5(r, g, b) ((((b)) << PICO_SCANVIDEO_PIXEL_BSHIFT) | (((g)) << PICO_SCANVIDEO_PIXEL_GSHIFT) | (((r)) << PICO_SCANVIDEO_PIXEL_RSHIFT))
+#define PICO_SCANVIDEO_R5_FROM_PIXEL(p) (((p) >> PICO_SCANVIDEO_PIXEL_RSHIFT) & 0x1f)
+#define PICO_SCANVIDEO_G5_FROM_PIXEL(p) (((p) >> PICO_SCANVIDEO_PIXEL_GSHIFT) & 0x1f)
+#define PICO_SCANVIDEO_B5_FROM_PIXEL(p) (((p) >> PICO_SCANVIDEO_PIXEL_BSHIFT) & 0x1f)
+
+typedef struct scanvideo_timing {
+    uint32_t clock_freq;
+
+    uint16_t h_active;
+    uint16_t v_active;
+
+    uint16_t h_front_porch;
+    uint16_t h_pulse;
+    uint16_t h_total;
+    uint8_t h_sync_polarity;
+
+    uint16_t v_front_porch;
+    uint16_t v_pulse;
+    uint16_t v_total;
+    uint8_t v_sync_polarity;
+
+    uint8_t enable_clock;
+    uint8_t clock_polarity;
+
+    uint8_t enable_den;
+} scanvideo_timing_t;
+
+typedef struct scanvideo_pio_program scanvideo_pio_program_t;
+
+typedef struct scanvideo_mode {
+    const scanvideo_timing_t *default_timing;
+    const scanvideo_pio_program_t *pio_program;
+
+    uint16_t width;
+    uint16_t height;
+    uint8_t xscale;
+    uint16_t yscale;
+    uint16_t yscale_denominator;
+} scanvideo_mode_t;
+
+extern const scanvideo_mode_t vga_mode_160x120_60;
+extern const scanvideo_mode_t vga_mode_213x160_60;
+extern const scanvideo_mode_t vga_mode_320x240_60;
+extern const scanvideo_mode_t vga_mode_640x480_60;
+extern const scanvideo_mode_t vga_mode_tft_800x480_50;
+extern const scanvideo_mode_t vga_mode_tft_400x240_50;
+
+enum {
+    SCANLINE_OK = 1,
+    SCANLINE_ERROR,
+    SCANLINE_SKIPPED
+};
+
+typedef struct scanvideo_scanline_buffer {
+    uint32_t scanline_id;
+    uint32_t *data;
+    uint16_t data_used;
+    uint16_t data_max;
+    void *user_data;
+    uint8_t status;
+} scanvideo_scanline_buffer_t;
+
+static inline uint16_t scanvideo_scanline_number(uint32_t scanline_id) {
+    return (uint16_t) scanline_id;
+}
+
+static inline uint32_t scanvideo_frame_number(uint32_t scanline_id) {
+    return (uint16_t) (scanline_id >> 16u);
+}
+
+#endif
@@ -0,0 +1,16 @@
+// Host stand-in for pico/scanvideo/composable_scanline.h
+// On the device these are offsets into the composable PIO program; on the
+// host they only need to be distinct for scanvideo_host.c to decode them.
+
+#ifndef HOST_PICO_SCANVIDEO_COMPOSABLE_SCANLINE_H
+#define HOST_PICO_SCANVIDEO_COMPOSABLE_SCANLINE_H
+
+#define COMPOSABLE_COLOR_RUN 0
+#define COMPOSABLE_EOL_ALIGN 1
+#define COMPOSABLE_EOL_SKIP_ALIGN 2
+#define COMPOSABLE_RAW_RUN 3
+#define COMPOSABLE_RAW_1P 4
+#define COMPOSABLE_RAW_2P 5
+#define COMPOSABLE_RAW_1P_SKIP_ALIGN 6
+
+#endif
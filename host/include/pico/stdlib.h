@@ -0,0 +1,48 @@
+// Host stand-in for pico/stdlib.h
+// Time comes from a simulated clock advanced by the host program.
+
+#ifndef HOST_PICO_STDLIB_H
+#define HOST_PICO_STDLIB_H
+
+#include <stdio.h>
+#include "pico.h"
+
+// Simulated microsecond clock
+extern uint64_t host_time_us;
+
+static inline uint32_t time_us_32(void) {
+    return (uint32_t)host_time_us;
+}
+
+static inline uint64_t time_us_64(void) {
+    return host_time_us;
+}
+
+static inline void sleep_us(uint64_t us) {
+    host_time_us += us;
+}
+
+static inline void sleep_ms(uint32_t ms) {
+    host_time_us += (uint64_t)ms * 1000;
+}
+
+// USB/UART stdio is not connected on the host
+static inline bool stdio_init_all(void) {
+    return true;
+}
+
+static inline int getchar_timeout_us(uint32_t timeout_us) {
+    (void)timeout_us;
+    return PICO_ERROR_TIMEOUT;
+}
+
+// Output goes to the host's stdout
+static inline int putchar_raw(int c) {
+    return putchar(c);
+}
+
+static inline void stdio_flush(void) {
+    fflush(stdout);
+}
+
+#endif
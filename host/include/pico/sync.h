@@ -0,0 +1,29 @@
+// Host stand-in for pico/sync.h
+
+#ifndef HOST_PICO_SYNC_H
+#define HOST_PICO_SYNC_H
+
+#include "pico.h"
+
+typedef volatile uint32_t spin_lock_t;
+
+int spin_lock_claim_unused(bool required);
+spin_lock_t *spin_lock_init(uint lock_num);
+
+static inline uint32_t spin_lock_blocking(spin_lock_t *lock) {
+    while(__atomic_exchange_n(lock, 1, __ATOMIC_ACQUIRE)) {
+    }
+    return 0;
+}
+
+static inline void spin_unlock(spin_lock_t *lock, uint32_t saved_irq) {
+    (void)saved_irq;
+    __atomic_store_n(lock, 0, __ATOMIC_RELEASE);
+}
+
+#define __mem_fence_acquire() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#define __mem_fence_release() __atomic_thread_fence(__ATOMIC_RELEASE)
+#define __compiler_memory_barrier() __atomic_signal_fence(__ATOMIC_SEQ_CST)
+#define __dmb() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+#endif
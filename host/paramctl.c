@@ -0,0 +1,396 @@
+// Host tool for the expo_demo USB parameter protocol
+//
+// paramctl <tty> name=value ...   Send one batch to a board (or emulator)
+// paramctl --emulate              Stand in for a board on a pty and log what
+//                                 would be applied each frame
+// paramctl --selftest [batches]   Drive the emulator over a pty and check that
+//                                 every batch is applied within one frame
+// paramctl --save-trace <tty> <file>
+//                                 Stop a pot trace recording (trace=1) and save
+//                                 the trace the board sends back
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "param_proto.h"
+#include "params.h"
+#include "trace.h"
+
+// Frame period of the 60 Hz modes
+#define FRAME_US 16667
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int set_raw(int fd) {
+    struct termios tio;
+    if(tcgetattr(fd, &tio) < 0) {
+        return -1;
+    }
+    cfmakeraw(&tio);
+    return tcsetattr(fd, TCSANOW, &tio);
+}
+
+static int parse_update(const char *arg, param_update_t *update) {
+    const char *eq = strchr(arg, '=');
+    if(!eq) {
+        return -1;
+    }
+
+    size_t len = eq - arg;
+    int id = -1;
+    for(int n = 0; n < PARAM_COUNT; n++) {
+        if(strlen(param_names[n]) == len && !strncmp(arg, param_names[n], len)) {
+            id = n;
+        }
+    }
+    if(id < 0) {
+        // Allow raw numeric IDs for parameters this tool doesn't know about
+        char *end;
+        long raw = strtol(arg, &end, 0);
+        if(end != eq || raw < 0 || raw > 255) {
+            return -1;
+        }
+        id = raw;
+    }
+
+    char *end;
+    long value = strtol(eq + 1, &end, 0);
+    if(*end || value < 0 || value > 0xffff) {
+        return -1;
+    }
+
+    update->id = id;
+    update->value = value;
+    return 0;
+}
+
+static int write_all(int fd, const uint8_t *data, size_t len) {
+    while(len) {
+        ssize_t n = write(fd, data, len);
+        if(n < 0) {
+            if(errno == EINTR || errno == EAGAIN) {
+                continue;
+            }
+            return -1;
+        }
+        data += n;
+        len -= n;
+    }
+    return 0;
+}
+
+// Board emulator
+
+typedef struct {
+    int master;
+    int slave;
+    volatile int stop;
+    // Called at each emulated vblank that applies a batch, with the applied
+    // values and a bit per value the batch changed
+    void (*on_apply)(const uint16_t *values, uint32_t mask, uint64_t t);
+} emulator_t;
+
+static int emulator_open(emulator_t *emu) {
+    emu->master = posix_openpt(O_RDWR | O_NOCTTY);
+    if(emu->master < 0 || grantpt(emu->master) < 0 || unlockpt(emu->master) < 0) {
+        return -1;
+    }
+    // Hold the slave open so reads on the master don't fail between senders
+    emu->slave = open(ptsname(emu->master), O_RDWR | O_NOCTTY);
+    if(emu->slave < 0 || set_raw(emu->slave) < 0) {
+        return -1;
+    }
+    emu->stop = 0;
+    return 0;
+}
+
+// Stand-in for the device's USB task and frame boundary: bytes are decoded as
+// they arrive and staged with params_stage, and params_apply_pending runs at
+// each emulated vblank, so this exercises the same staging the board uses
+static void *emulator_run(void *arg) {
+    emulator_t *emu = arg;
+    param_decoder_t dec;
+
+    params_init();
+    param_decoder_init(&dec);
+    uint64_t next_vblank = now_us() + FRAME_US;
+
+    while(!emu->stop) {
+        uint64_t t = now_us();
+        if(t >= next_vblank) {
+            effect_params_t before = effect_params;
+            if(params_apply_pending()) {
+                uint32_t changed = 0;
+                for(int id = 0; id < PARAM_COUNT; id++) {
+                    if(effect_params.value[id] != before.value[id]) {
+                        changed |= 1u << id;
+                    }
+                }
+                emu->on_apply(effect_params.value, changed, t);
+            }
+            next_vblank += FRAME_US;
+            continue;
+        }
+
+        struct pollfd pfd = {.fd = emu->master, .events = POLLIN};
+        int timeout_ms = (int)((next_vblank - t + 999) / 1000);
+        if(poll(&pfd, 1, timeout_ms) <= 0) {
+            continue;
+        }
+
+        uint8_t buf[256];
+        ssize_t n = read(emu->master, buf, sizeof(buf));
+        for(ssize_t k = 0; k < n; k++) {
+            if(param_decoder_feed(&dec, buf[k])) {
+                params_stage(dec.updates, dec.count);
+            }
+        }
+    }
+    return NULL;
+}
+
+static void log_apply(const uint16_t *values, uint32_t mask, uint64_t t) {
+    printf("[%10.3f ms]", t / 1000.0);
+    for(int id = 0; id < PARAM_COUNT; id++) {
+        if(mask & (1u << id)) {
+            printf(" %s=%u", param_names[id], values[id]);
+        }
+    }
+    printf("\n");
+    fflush(stdout);
+}
+
+static int run_emulate(void) {
+    emulator_t emu = {.on_apply = log_apply};
+    if(emulator_open(&emu) < 0) {
+        perror("pty");
+        return 1;
+    }
+    printf("emulating board on %s\n", ptsname(emu.master));
+    fflush(stdout);
+    emulator_run(&emu);
+    return 0;
+}
+
+// Self-test: each batch carries its sequence number split across two byte-wide
+// parameters, since params_stage clamps values to each parameter's range
+
+#define SELFTEST_MAX 4096
+#define SELFTEST_SEQ_LO PARAM_PALETTE_CYCLE
+#define SELFTEST_SEQ_HI PARAM_CA_RULE
+
+static uint64_t sent_us[SELFTEST_MAX];
+static uint64_t applied_us[SELFTEST_MAX];
+
+static void record_apply(const uint16_t *values, uint32_t mask, uint64_t t) {
+    (void)mask;
+    uint16_t seq = values[SELFTEST_SEQ_LO] | values[SELFTEST_SEQ_HI] << 8;
+    if(seq < SELFTEST_MAX) {
+        applied_us[seq] = t;
+    }
+}
+
+static int run_selftest(int batches) {
+    if(batches < 1 || batches > SELFTEST_MAX) {
+        fprintf(stderr, "batch count must be 1..%d\n", SELFTEST_MAX);
+        return 1;
+    }
+
+    emulator_t emu = {.on_apply = record_apply};
+    if(emulator_open(&emu) < 0) {
+        perror("pty");
+        return 1;
+    }
+    pthread_t thread;
+    pthread_create(&thread, NULL, emulator_run, &emu);
+
+    srand(1);
+    for(int seq = 0; seq < batches; seq++) {
+        param_update_t updates[PARAM_COUNT];
+        uint8_t count = 0;
+        updates[count++] = (param_update_t){SELFTEST_SEQ_LO, seq & 0xff};
+        updates[count++] = (param_update_t){SELFTEST_SEQ_HI, seq >> 8};
+        updates[count++] = (param_update_t){PARAM_BLOCK_SIZE, 4 << (rand() % 6)};
+        updates[count++] = (param_update_t){PARAM_DEMO, rand() % DEMO_COUNT};
+
+        uint8_t packet[PARAM_PROTO_MAX_PACKET];
+        size_t len = param_proto_encode(packet, updates, count);
+        sent_us[seq] = now_us();
+        write_all(emu.slave, packet, len);
+
+        // Space batches so each lands in its own frame
+        usleep(FRAME_US + rand() % FRAME_US);
+    }
+    usleep(2 * FRAME_US);
+    emu.stop = 1;
+    pthread_join(thread, NULL);
+
+    uint64_t worst = 0, total = 0;
+    int missing = 0, late = 0;
+    for(int seq = 0; seq < batches; seq++) {
+        if(!applied_us[seq]) {
+            missing++;
+            continue;
+        }
+        uint64_t latency = applied_us[seq] - sent_us[seq];
+        total += latency;
+        if(latency > worst) {
+            worst = latency;
+        }
+        // Allow 1 ms for pty scheduling jitter on top of the frame period
+        if(latency > FRAME_US + 1000) {
+            late++;
+        }
+    }
+    int applied = batches - missing;
+    printf("batches: %d applied, %d missing, %d over one frame\n", applied, missing, late);
+    if(applied) {
+        printf("latency: avg %.2f ms, worst %.2f ms (frame %.2f ms)\n",
+               total / 1000.0 / applied, worst / 1000.0, FRAME_US / 1000.0);
+    }
+    return (missing || late) ? 1 : 0;
+}
+
+static int run_send(const char *path, int argc, char **argv) {
+    param_update_t updates[PARAM_PROTO_MAX_UPDATES];
+    if(argc > PARAM_PROTO_MAX_UPDATES) {
+        fprintf(stderr, "at most %d updates per batch\n", PARAM_PROTO_MAX_UPDATES);
+        return 1;
+    }
+    for(int n = 0; n < argc; n++) {
+        if(parse_update(argv[n], &updates[n]) < 0) {
+            fprintf(stderr, "bad update '%s' (expected name=value)\n", argv[n]);
+            return 1;
+        }
+    }
+
+    int fd = open(path, O_RDWR | O_NOCTTY);
+    if(fd < 0) {
+        perror(path);
+        return 1;
+    }
+    set_raw(fd);
+
+    uint8_t packet[PARAM_PROTO_MAX_PACKET];
+    size_t len = param_proto_encode(packet, updates, argc);
+    if(write_all(fd, packet, len) < 0) {
+        perror("write");
+        close(fd);
+        return 1;
+    }
+    tcdrain(fd);
+    close(fd);
+    return 0;
+}
+
+// Send trace=off and read back the trace the board writes when recording stops
+static int run_save_trace(const char *path, const char *out_path) {
+    int fd = open(path, O_RDWR | O_NOCTTY);
+    if(fd < 0) {
+        perror(path);
+        return 1;
+    }
+    set_raw(fd);
+
+    param_update_t stop = {PARAM_TRACE, TRACE_OFF};
+    uint8_t packet[PARAM_PROTO_MAX_PACKET];
+    size_t len = param_proto_encode(packet, &stop, 1);
+    if(write_all(fd, packet, len) < 0) {
+        perror("write");
+        close(fd);
+        return 1;
+    }
+
+    static uint8_t data[TRACE_MAX_BYTES];
+    size_t have = 0;
+    size_t want = TRACE_HEADER_BYTES;
+    uint64_t deadline = now_us() + 2000000;
+    while(have < want) {
+        uint64_t t = now_us();
+        struct pollfd pfd = {.fd = fd, .events = POLLIN};
+        if(t >= deadline || poll(&pfd, 1, (int)((deadline - t) / 1000) + 1) <= 0) {
+            fprintf(stderr, "no trace received (is the board recording?)\n");
+            close(fd);
+            return 1;
+        }
+        ssize_t n = read(fd, data + have, want - have);
+        if(n <= 0) {
+            continue;
+        }
+        have += n;
+
+        // Skip anything before the header, then read the whole trace
+        if(want == TRACE_HEADER_BYTES) {
+            size_t start = 0;
+            while(start < have && data[start] != 'C') {
+                start++;
+            }
+            memmove(data, data + start, have - start);
+            have -= start;
+            if(have == TRACE_HEADER_BYTES) {
+                if(memcmp(data, "CBT", 3)) {
+                    memmove(data, data + 1, --have);
+                    continue;
+                }
+                want = TRACE_HEADER_BYTES + 4 * (size_t)(data[3] | data[4] << 8) + 1;
+            }
+        }
+    }
+    close(fd);
+
+    static trace_t trace;
+    if(!trace_read(&trace, data, have)) {
+        fprintf(stderr, "received trace is corrupt\n");
+        return 1;
+    }
+    FILE *out = fopen(out_path, "wb");
+    if(!out || fwrite(data, 1, have, out) != have || fclose(out)) {
+        perror(out_path);
+        return 1;
+    }
+    printf("saved %u trace entries to %s\n", trace.count, out_path);
+    return 0;
+}
+
+static void usage(void) {
+    fprintf(stderr,
+            "usage: paramctl <tty> name=value ...\n"
+            "       paramctl --emulate\n"
+            "       paramctl --selftest [batches]\n"
+            "       paramctl --save-trace <tty> <file>\n"
+            "parameters:");
+    for(int n = 0; n < PARAM_COUNT; n++) {
+        fprintf(stderr, " %s", param_names[n]);
+    }
+    fprintf(stderr, "\n");
+}
+
+int main(int argc, char **argv) {
+    if(argc >= 2 && !strcmp(argv[1], "--emulate")) {
+        return run_emulate();
+    }
+    if(argc >= 2 && !strcmp(argv[1], "--selftest")) {
+        return run_selftest(argc >= 3 ? atoi(argv[2]) : 120);
+    }
+    if(argc == 4 && !strcmp(argv[1], "--save-trace")) {
+        return run_save_trace(argv[2], argv[3]);
+    }
+    if(argc >= 3) {
+        return run_send(argv[1], argc - 2, argv + 2);
+    }
+    usage();
+    return 1;
+}
@@ -0,0 +1,155 @@
+// Particle benchmark
+//
+// Steps and draws both particle systems at increasing particle counts for
+// the video mode it was built for (CMakeLists.txt builds one executable per
+// mode, and the particles_bench_all target runs them all).
+//
+// particles_bench_<mode> [FRAMES]
+//
+// For each count it reports the host time to step and bucket one frame and to
+// draw every line, the busiest line's share of the room a demo has in the
+// scanline buffer (see governor.h), and lines holding more than
+// PARTICLE_LINE_MAX particles (drawn with the rest skipped).
+//
+// It then reports the mode's capacity for each system: the most particles,
+// in steps of CAPACITY_STEP up to PARTICLE_POOL, that every line of the
+// measured frames draws in full within its room. Host times are for comparing
+// counts and modes; on the board the OSD headroom shows whether a frame also
+// has time for them.
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "video_mode.h"
+#include "params.h"
+#include "palette.h"
+#include "regions.h"
+#include "particles.h"
+#include "wall.h"
+#include "control.h"
+#include "governor.h"
+
+bool regions_show_demo(uint8_t demo) {
+    (void)demo;
+    return true;
+}
+
+// The wall code reads the pots for its leader's sync messages
+uint16_t control_pot(uint n) {
+    (void)n;
+    return 0;
+}
+
+// Frames run before measuring, so the sparks fountain is in full flow
+#define WARMUP_FRAMES 300
+
+// Particle counts tried when looking for the capacity
+#define CAPACITY_STEP 32
+
+static const char *const system_names[PARTICLES_SYSTEM_COUNT] = {
+    [PARTICLES_STARFIELD] = "starfield",
+    [PARTICLES_SPARKS]    = "sparks",
+};
+
+static double now_us(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e6 + t.tv_nsec / 1e3;
+}
+
+typedef struct {
+    double step_us;     // Average host time to step one frame
+    double draw_us;     // Average host time to draw every line of a frame
+    uint max_halfwords; // Busiest line's tokens
+    uint full_lines;    // Lines (summed over frames) with particles left undrawn
+} result_t;
+
+static result_t run(uint8_t system, uint16_t count, uint frames) {
+    // Room for a line of particles even past the scanline buffer size
+    static uint16_t line[4 * PICO_SCANVIDEO_MAX_SCANLINE_BUFFER_WORDS + 8 * PARTICLE_LINE_MAX];
+    result_t r = {0};
+
+    for(uint f = 0; f < WARMUP_FRAMES; f++) {
+        particles_step(system, count, 1);
+        particles_begin_frame();
+    }
+
+    double step_us = 0, draw_us = 0;
+    for(uint f = 0; f < frames; f++) {
+        double t0 = now_us();
+        particles_step(system, count, 1);
+        double t1 = now_us();
+        particles_begin_frame();
+
+        for(uint16_t y = 0; y < vga_mode.height; y++) {
+            uint16_t *end = particles_span(system, line, y, 0, vga_mode.width);
+            r.max_halfwords = MAX(r.max_halfwords, (uint)(end - line));
+            if(particles_line_count(system, y) > PARTICLE_LINE_MAX) {
+                r.full_lines++;
+            }
+        }
+        double t2 = now_us();
+
+        step_us += t1 - t0;
+        draw_us += t2 - t1;
+    }
+
+    r.step_us = step_us / frames;
+    r.draw_us = draw_us / frames;
+    return r;
+}
+
+static bool fits(const result_t *r, uint room) {
+    return r->max_halfwords <= room && !r->full_lines;
+}
+
+// Most particles whose lines all fit, or 0 if even CAPACITY_STEP don't
+static uint capacity(uint8_t system, uint frames, uint room) {
+    uint best = 0;
+    for(uint count = CAPACITY_STEP; count <= PARTICLE_POOL; count += CAPACITY_STEP) {
+        result_t r = run(system, count, frames);
+        if(!fits(&r, room)) {
+            break;
+        }
+        best = count;
+    }
+    return best;
+}
+
+int main(int argc, char **argv) {
+    uint frames = (argc > 1) ? (uint)atoi(argv[1]) : 600;
+    if(!frames) {
+        fprintf(stderr, "usage: %s [FRAMES]\n", argv[0]);
+        return 1;
+    }
+
+    params_init();
+    wall_init();
+    palette_init();
+    particles_init();
+
+    const scanvideo_timing_t *timing = vga_mode.default_timing;
+    double frame_us = (double)timing->h_total * timing->v_total * 1e6 / timing->clock_freq;
+    uint room = 2 * PICO_SCANVIDEO_MAX_SCANLINE_BUFFER_WORDS - GOVERNOR_LINE_MARGIN_HALFWORDS;
+    printf("%ux%u: %.0f us per frame, %u halfwords per line for a demo\n",
+           vga_mode.width, vga_mode.height, frame_us, room);
+
+    for(uint8_t system = 0; system < PARTICLES_SYSTEM_COUNT; system++) {
+        printf("  %-10s %6s %10s %10s %10s %10s\n", system_names[system], "count", "step us", "draw us", "max line", "full lines");
+        for(uint count = 64; count <= PARTICLE_POOL; count *= 2) {
+            result_t r = run(system, count, frames);
+            printf("  %-10s %6u %10.1f %10.1f %6u/%-3u %10u\n", "", count, r.step_us, r.draw_us,
+                   r.max_halfwords, room, r.full_lines);
+        }
+
+        uint most = capacity(system, frames, room);
+        if(most == PARTICLE_POOL) {
+            printf("  %-10s capacity %u particles (the whole pool)\n", "", most);
+        } else {
+            printf("  %-10s capacity %u particles\n", "", most);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,171 @@
+// Host implementations of the Pico SDK pieces used by the expo_demo sources
+
+#include "pico.h"
+#include "pico/stdlib.h"
+#include "pico/sync.h"
+#include "pico/scanvideo.h"
+#include "hardware/adc.h"
+#include "hardware/flash.h"
+#include "hardware/structs/xip_ctrl.h"
+#include "hardware/uart.h"
+#include <string.h>
+
+uint64_t host_time_us;
+
+uint16_t host_adc_value[HOST_ADC_INPUTS];
+uint host_adc_input;
+
+uint8_t host_flash[PICO_FLASH_SIZE_BYTES];
+
+xip_ctrl_hw_t host_xip_ctrl;
+
+void flash_range_erase(uint32_t flash_offs, size_t count) {
+    assert(!(flash_offs % FLASH_SECTOR_SIZE) && !(count % FLASH_SECTOR_SIZE));
+    assert(flash_offs + count <= PICO_FLASH_SIZE_BYTES);
+    memset(host_flash + flash_offs, 0xff, count);
+}
+
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count) {
+    assert(!(flash_offs % FLASH_PAGE_SIZE) && !(count % FLASH_PAGE_SIZE));
+    assert(flash_offs + count <= PICO_FLASH_SIZE_BYTES);
+    for(size_t n = 0; n < count; n++) {
+        host_flash[flash_offs + n] &= data[n];
+    }
+}
+
+// Bytes queued for each UART to read
+#define HOST_UART_QUEUE 256
+
+uart_inst_t host_uarts[2] = {{0}, {1}};
+void (*host_uart_tx)(uart_inst_t *uart, uint8_t c);
+
+static uint8_t uart_queue[2][HOST_UART_QUEUE];
+static uint uart_head[2], uart_tail[2];
+
+void host_uart_receive(uart_inst_t *uart, uint8_t c) {
+    uint n = uart->index;
+    // A full queue drops the byte, like a receive FIFO overrun
+    if(uart_tail[n] - uart_head[n] < HOST_UART_QUEUE) {
+        uart_queue[n][uart_tail[n]++ % HOST_UART_QUEUE] = c;
+    }
+}
+
+uint uart_init(uart_inst_t *uart, uint baudrate) {
+    uart_head[uart->index] = uart_tail[uart->index] = 0;
+    return baudrate;
+}
+
+void uart_write_blocking(uart_inst_t *uart, const uint8_t *src, size_t len) {
+    for(size_t n = 0; n < len && host_uart_tx; n++) {
+        host_uart_tx(uart, src[n]);
+    }
+}
+
+bool uart_is_readable(uart_inst_t *uart) {
+    return uart_head[uart->index] != uart_tail[uart->index];
+}
+
+char uart_getc(uart_inst_t *uart) {
+    uint n = uart->index;
+    assert(uart_head[n] != uart_tail[n]);
+    return uart_queue[n][uart_head[n]++ % HOST_UART_QUEUE];
+}
+
+#define HOST_SPIN_LOCKS 32
+
+static spin_lock_t spin_locks[HOST_SPIN_LOCKS];
+static uint next_spin_lock;
+
+int spin_lock_claim_unused(bool required) {
+    assert(!required || next_spin_lock < HOST_SPIN_LOCKS);
+    return (next_spin_lock < HOST_SPIN_LOCKS) ? (int)next_spin_lock++ : -1;
+}
+
+spin_lock_t *spin_lock_init(uint lock_num) {
+    spin_locks[lock_num] = 0;
+    return &spin_locks[lock_num];
+}
+
+// Timings from pico_scanvideo_dpi
+static const scanvideo_timing_t vga_timing_640x480_60_default = {
+    .clock_freq = 25000000,
+
+    .h_active = 640,
+    .v_active = 480,
+
+    .h_front_porch = 16,
+    .h_pulse = 64,
+    .h_total = 800,
+    .h_sync_polarity = 1,
+
+    .v_front_porch = 1,
+    .v_pulse = 2,
+    .v_total = 523,
+    .v_sync_polarity = 1,
+};
+
+// Approximation of the 50 Hz TFT panel timing (only the line period matters here)
+static const scanvideo_timing_t tft_timing_800x480_50 = {
+    .clock_freq = 30000000,
+
+    .h_active = 800,
+    .v_active = 480,
+
+    .h_front_porch = 40,
+    .h_pulse = 48,
+    .h_total = 1056,
+    .h_sync_polarity = 0,
+
+    .v_front_porch = 13,
+    .v_pulse = 3,
+    .v_total = 568,
+    .v_sync_polarity = 0,
+};
+
+const scanvideo_mode_t vga_mode_160x120_60 = {
+    .default_timing = &vga_timing_640x480_60_default,
+    .width = 160,
+    .height = 120,
+    .xscale = 4,
+    .yscale = 4,
+};
+
+const scanvideo_mode_t vga_mode_213x160_60 = {
+    .default_timing = &vga_timing_640x480_60_default,
+    .width = 213,
+    .height = 160,
+    .xscale = 3,
+    .yscale = 3,
+};
+
+const scanvideo_mode_t vga_mode_320x240_60 = {
+    .default_timing = &vga_timing_640x480_60_default,
+    .width = 320,
+    .height = 240,
+    .xscale = 2,
+    .yscale = 2,
+};
+
+const scanvideo_mode_t vga_mode_640x480_60 = {
+    .default_timing = &vga_timing_640x480_60_default,
+    .width = 640,
+    .height = 480,
+    .xscale = 1,
+    .yscale = 1,
+};
+
+const scanvideo_mode_t vga_mode_tft_800x480_50 = {
+    .default_timing = &tft_timing_800x480_50,
+    .width = 800,
+    .height = 480,
+    .xscale = 1,
+    .yscale = 1,
+};
+
+const scanvideo_mode_t vga_mode_tft_400x240_50 = {
+    .default_timing = &tft_timing_800x480_50,
+    .width = 400,
+    .height = 240,
+    .xscale = 2,
+    .yscale = 2,
+};
@@ -0,0 +1,498 @@
+// Offline renderer for the expo_demo effects
+//
+// Runs the same per-frame pipeline as core 1 and writes the result as video.
+// Lines of each frame are shared out across worker threads, and the previous
+// frame is written to disk while the next one renders.
+//
+// render [options]
+//   -o FILE        Output file (.y4m for YUV4MPEG2 4:4:4, otherwise raw RGB24)
+//   -n FRAMES      Number of frames to render (default 3600, one minute)
+//   -a FILE        Pot automation track (see below)
+//   -t FILE        Replay a pot trace saved with paramctl --save-trace
+//   -j THREADS     Worker threads (default: one per host core)
+//   -s SCALE       Integer upscale of the output (default 1)
+//   -p NAME=VALUE  Set a parameter at the first frame (repeatable)
+//   -b FILE        Video wall sync line (see below)
+//   -d PPM         Run this board's clock PPM parts per million fast (negative for slow)
+//   -w WALL_FRAME  Stop at the first frame from this wall frame on that moved
+//                  on by one step, write only that frame and print its wall frame
+//
+// The automation track has one keyframe per line, "frame pot0 pot1", with raw
+// ADC values (0-4095) that are linearly interpolated between keyframes and
+// read through the same pot mapping as the board. '#' starts a comment.
+//
+// To render the screens of a video wall, set wall_columns, wall_rows and
+// wall_tile with -p (they take effect at start-up, as on the board) and render
+// the leading tile 0 first. Its sync line is written to the -b file as one
+// "time_us byte" line per byte, and the other tiles read it back from the -b
+// file, each byte arriving at its time on their own clock.
+//
+// Effects stepped on core 0 show the state of the wall frame before, so just
+// after a follower catches up two frames at once they are a step behind. -w
+// stops on a frame after a single step, where a follower rendered with -d
+// should match one rendered without it stopped at the same wall frame.
+
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "pico/stdlib.h"
+#include "hardware/adc.h"
+#include "scanvideo_host.h"
+#include "video_mode.h"
+#include "params.h"
+#include "control.h"
+#include "effects.h"
+#include "osd.h"
+#include "frame.h"
+#include "telemetry.h"
+#include "governor.h"
+#include "trace.h"
+#include "modulation.h"
+#include "trig.h"
+#include "persist.h"
+#include "wall.h"
+#include "hardware/uart.h"
+
+#define MAX_KEYFRAMES 4096
+#define MAX_THREADS 256
+
+typedef struct {
+    uint32_t frame;
+    uint16_t pot[2];
+} keyframe_t;
+
+static keyframe_t keyframes[MAX_KEYFRAMES];
+static int keyframe_count;
+
+// Output settings
+static bool y4m;
+static uint scale = 1;
+static uint out_width, out_height;
+static size_t frame_bytes;
+
+// Output frames (one being written while the other renders)
+static uint8_t *out_frames[2];
+static uint8_t *render_target;
+static uint32_t render_frame;
+
+// RGB555 to output pixel lookup (3 bytes per color: RGB or YUV)
+static uint8_t color_lut[1 << 16][3];
+
+static pthread_barrier_t start_barrier, done_barrier;
+static volatile bool stop_workers;
+static uint thread_count;
+
+static int load_automation(const char *path) {
+    FILE *f = fopen(path, "r");
+    if(!f) {
+        perror(path);
+        return -1;
+    }
+
+    char line[256];
+    int line_num = 0;
+    while(fgets(line, sizeof(line), f)) {
+        line_num++;
+        char *hash = strchr(line, '#');
+        if(hash) {
+            *hash = 0;
+        }
+        unsigned frame, pot0, pot1;
+        int n = sscanf(line, "%u %u %u", &frame, &pot0, &pot1);
+        if(n <= 0) {
+            continue;
+        }
+        if(n != 3 || pot0 > 4095 || pot1 > 4095 || keyframe_count == MAX_KEYFRAMES ||
+           (keyframe_count && frame <= keyframes[keyframe_count - 1].frame)) {
+            fprintf(stderr, "%s:%d: expected increasing 'frame pot0 pot1'\n", path, line_num);
+            fclose(f);
+            return -1;
+        }
+        keyframes[keyframe_count++] = (keyframe_t){frame, {pot0, pot1}};
+    }
+    fclose(f);
+    return 0;
+}
+
+// Pot value at a frame, interpolated between keyframes
+static uint16_t automation_pot(uint32_t frame, uint pot) {
+    if(!keyframe_count) {
+        return 0;
+    }
+    if(frame <= keyframes[0].frame) {
+        return keyframes[0].pot[pot];
+    }
+    for(int k = 1; k < keyframe_count; k++) {
+        if(frame < keyframes[k].frame) {
+            const keyframe_t *a = &keyframes[k - 1];
+            const keyframe_t *b = &keyframes[k];
+            int32_t delta = (int32_t)b->pot[pot] - a->pot[pot];
+            return a->pot[pot] + delta * (int32_t)(frame - a->frame) / (int32_t)(b->frame - a->frame);
+        }
+    }
+    return keyframes[keyframe_count - 1].pot[pot];
+}
+
+static void build_color_lut(void) {
+    for(uint32_t pixel = 0; pixel < (1 << 16); pixel++) {
+        uint8_t rgb[3];
+        scanvideo_host_rgb8(pixel, rgb);
+        if(!y4m) {
+            memcpy(color_lut[pixel], rgb, 3);
+            continue;
+        }
+        // BT.601 studio range
+        int r = rgb[0], g = rgb[1], b = rgb[2];
+        color_lut[pixel][0] = 16 + ((66 * r + 129 * g + 25 * b + 128) >> 8);
+        color_lut[pixel][1] = 128 + ((-38 * r - 74 * g + 112 * b + 128) >> 8);
+        color_lut[pixel][2] = 128 + ((112 * r - 94 * g - 18 * b + 128) >> 8);
+    }
+}
+
+// Store one decoded line (scaled) into the output frame
+static void store_line(uint8_t *out, uint16_t y, const uint16_t *pixels) {
+    size_t plane = (size_t)out_width * out_height;
+    for(uint sy = 0; sy < scale; sy++) {
+        size_t row = (size_t)(y * scale + sy) * out_width;
+        for(uint x = 0; x < vga_mode.width; x++) {
+            const uint8_t *c = color_lut[pixels[x]];
+            for(uint sx = 0; sx < scale; sx++) {
+                size_t i = row + x * scale + sx;
+                if(y4m) {
+                    // Planar Y, U, V after the FRAME header
+                    out[6 + i] = c[0];
+                    out[6 + plane + i] = c[1];
+                    out[6 + 2 * plane + i] = c[2];
+                } else {
+                    memcpy(&out[3 * i], c, 3);
+                }
+            }
+        }
+    }
+}
+
+static void *worker(void *arg) {
+    uint index = (uintptr_t)arg;
+    // Alternate between two lines so the last one drawn can be passed as previous
+    host_scanline_t lines[2];
+    uint16_t *pixels = malloc(vga_mode.width * sizeof(uint16_t));
+
+    while(true) {
+        pthread_barrier_wait(&start_barrier);
+        if(stop_workers) {
+            break;
+        }
+
+        // Interleave lines so every thread gets a share of each region
+        uint32_t frame = render_frame;
+        const scanvideo_scanline_buffer_t *previous = NULL;
+        for(uint y = index; y < vga_mode.height; y += thread_count) {
+            host_scanline_t *line = &lines[y & 1];
+            host_scanline_begin(line, frame, y);
+            frame_draw_line(&line->buffer, previous);
+            previous = &line->buffer;
+            if(scanvideo_host_decode(&line->buffer, pixels, vga_mode.width) != vga_mode.width) {
+                fprintf(stderr, "frame %u line %u: bad scanline tokens\n", frame, y);
+                exit(1);
+            }
+            store_line(render_target, y, pixels);
+        }
+
+        pthread_barrier_wait(&done_barrier);
+    }
+
+    free(pixels);
+    return NULL;
+}
+
+// Sync line of a video wall: bytes sent by the leader, or to be received by a follower
+typedef struct {
+    uint64_t time_us;
+    uint8_t c;
+} bus_byte_t;
+
+static FILE *bus_out;
+static bus_byte_t *bus_bytes;
+static size_t bus_count, bus_next;
+
+static void bus_send(uart_inst_t *uart, uint8_t c) {
+    (void)uart;
+    fprintf(bus_out, "%llu %u\n", (unsigned long long)host_time_us, c);
+}
+
+static int load_bus(const char *path) {
+    FILE *f = fopen(path, "r");
+    if(!f) {
+        perror(path);
+        return -1;
+    }
+    size_t size = 0;
+    unsigned long long time_us;
+    unsigned c;
+    while(fscanf(f, "%llu %u", &time_us, &c) == 2) {
+        if(bus_count == size) {
+            size = size ? 2 * size : 4096;
+            bus_bytes = realloc(bus_bytes, size * sizeof(bus_byte_t));
+        }
+        bus_bytes[bus_count++] = (bus_byte_t){time_us, c};
+    }
+    fclose(f);
+    return 0;
+}
+
+// Pass on the bytes the leader has sent by now
+static void bus_receive(void) {
+    while(bus_next < bus_count && bus_bytes[bus_next].time_us <= host_time_us) {
+        host_uart_receive(uart1, bus_bytes[bus_next++].c);
+    }
+}
+
+static int parse_param(const char *arg, param_update_t *update) {
+    const char *eq = strchr(arg, '=');
+    if(!eq) {
+        return -1;
+    }
+    for(int id = 0; id < PARAM_COUNT; id++) {
+        if(strlen(param_names[id]) == (size_t)(eq - arg) && !strncmp(arg, param_names[id], eq - arg)) {
+            update->id = id;
+            update->value = atoi(eq + 1);
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static int load_trace(const char *path) {
+    static uint8_t data[TRACE_MAX_BYTES + 1];
+    FILE *f = fopen(path, "rb");
+    if(!f) {
+        perror(path);
+        return -1;
+    }
+    size_t len = fread(data, 1, sizeof(data), f);
+    fclose(f);
+    if(!control_load_trace(data, len)) {
+        fprintf(stderr, "%s: not a pot trace\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+static void usage(void) {
+    fprintf(stderr, "usage: render [-o out.y4m|out.rgb] [-n frames] [-a automation.txt] [-t trace.bin] [-j threads] [-s scale] "
+                    "[-b bus.txt] [-d ppm] [-w wall_frame] [-p name=value]...\n");
+}
+
+int main(int argc, char **argv) {
+    const char *out_path = "out.y4m";
+    const char *trace_path = NULL;
+    const char *bus_path = NULL;
+    long drift_ppm = 0;
+    uint32_t stop_wall_frame = 0;
+    uint32_t frames = 3600;
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    param_update_t overrides[PARAM_PROTO_MAX_UPDATES + 1];
+    uint override_count = 0;
+
+    int opt;
+    while((opt = getopt(argc, argv, "o:n:a:t:j:s:p:b:d:w:")) != -1) {
+        switch(opt) {
+            case 'o':
+                out_path = optarg;
+                break;
+            case 'n':
+                frames = strtoul(optarg, NULL, 0);
+                break;
+            case 'a':
+                if(load_automation(optarg) < 0) {
+                    return 1;
+                }
+                break;
+            case 't':
+                trace_path = optarg;
+                break;
+            case 'j':
+                threads = atol(optarg);
+                break;
+            case 's':
+                scale = atoi(optarg);
+                break;
+            case 'p':
+                if(override_count == PARAM_PROTO_MAX_UPDATES || parse_param(optarg, &overrides[override_count]) < 0) {
+                    fprintf(stderr, "bad parameter '%s'\n", optarg);
+                    return 1;
+                }
+                override_count++;
+                break;
+            case 'b':
+                bus_path = optarg;
+                break;
+            case 'd':
+                drift_ppm = atol(optarg);
+                break;
+            case 'w':
+                stop_wall_frame = strtoul(optarg, NULL, 0);
+                break;
+            default:
+                usage();
+                return 1;
+        }
+    }
+    if(scale < 1 || threads < 1 || drift_ppm <= -1000000) {
+        usage();
+        return 1;
+    }
+    thread_count = (threads > MAX_THREADS) ? MAX_THREADS : threads;
+
+    size_t len = strlen(out_path);
+    y4m = len >= 4 && !strcmp(out_path + len - 4, ".y4m");
+    out_width = vga_mode.width * scale;
+    out_height = vga_mode.height * scale;
+    frame_bytes = (size_t)out_width * out_height * 3 + (y4m ? 6 : 0);
+    for(int n = 0; n < 2; n++) {
+        out_frames[n] = malloc(frame_bytes);
+        if(y4m) {
+            memcpy(out_frames[n], "FRAME\n", 6);
+        }
+    }
+    build_color_lut();
+
+    FILE *out = fopen(out_path, "wb");
+    if(!out) {
+        perror(out_path);
+        return 1;
+    }
+    if(y4m) {
+        const scanvideo_timing_t *timing = vga_mode.default_timing;
+        uint fps = (timing->clock_freq + timing->h_total * timing->v_total / 2) / (timing->h_total * timing->v_total);
+        fprintf(out, "YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C444\n", out_width, out_height, fps);
+    }
+
+    // Same start-up order as the board, with the wall layout from the command line
+    params_init();
+    persist_load_scene();
+    param_update_t wall_overrides[PARAM_PROTO_MAX_UPDATES];
+    uint wall_override_count = 0;
+    for(uint n = 0; n < override_count; n++) {
+        uint8_t id = overrides[n].id;
+        if(id == PARAM_WALL_COLUMNS || id == PARAM_WALL_ROWS || id == PARAM_WALL_TILE) {
+            wall_overrides[wall_override_count++] = overrides[n];
+        }
+    }
+    if(wall_override_count) {
+        params_stage(wall_overrides, wall_override_count);
+        params_apply_pending();
+    }
+    wall_init();
+    trig_init();
+    effects_init();
+    persist_save_tables();
+    governor_init();
+    telemetry_init();
+    host_adc_value[0] = automation_pot(0, 0);
+    host_adc_value[1] = automation_pot(0, 1);
+    control_init();
+    if(trace_path) {
+        // The trace replaces the automation track from the second frame
+        if(load_trace(trace_path) < 0) {
+            return 1;
+        }
+        overrides[override_count++] = (param_update_t){PARAM_TRACE, TRACE_REPLAY};
+    }
+    if(override_count) {
+        params_stage(overrides, override_count);
+    }
+
+    pthread_barrier_init(&start_barrier, NULL, thread_count + 1);
+    pthread_barrier_init(&done_barrier, NULL, thread_count + 1);
+    pthread_t workers[MAX_THREADS];
+    for(uintptr_t n = 0; n < thread_count; n++) {
+        pthread_create(&workers[n], NULL, worker, (void *)n);
+    }
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    // Tile 0 of a wall sends the sync, the others receive it
+    if(bus_path && !wall_x0 && !wall_y0) {
+        bus_out = fopen(bus_path, "w");
+        if(!bus_out) {
+            perror(bus_path);
+            return 1;
+        }
+        host_uart_tx = bus_send;
+    } else if(bus_path && load_bus(bus_path) < 0) {
+        return 1;
+    }
+
+    // A fast clock runs the display fast, so frames take less time on the shared clock
+    const scanvideo_timing_t *timing = vga_mode.default_timing;
+    double frame_us = (double)timing->h_total * timing->v_total * 1e6 / timing->clock_freq / (1 + drift_ppm / 1e6);
+
+    uint32_t rendered = 0;
+    for(uint32_t frame = 0; frame < frames; frame++) {
+        // Core 0: pots (from the automation track), modulation, OSD and effects stepped on core 0
+        host_time_us = (uint64_t)(frame * frame_us);
+        bus_receive();
+        host_adc_value[0] = automation_pot(frame, 0);
+        host_adc_value[1] = automation_pot(frame, 1);
+        control_poll();
+        modulation_poll();
+        persist_poll();
+        osd_poll();
+        effects_poll();
+
+        // Core 1: frame boundary (host lines are not timed, so headroom reads 100%)
+        if(frame) {
+            telemetry_line(0);
+            telemetry_end_frame();
+        }
+        uint32_t previous_wall_frame = wall_frame;
+        frame_begin(frame == 0);
+
+        render_target = out_frames[frame & 1];
+        render_frame = frame;
+        pthread_barrier_wait(&start_barrier);
+        if(!stop_wall_frame && frame && fwrite(out_frames[(frame - 1) & 1], 1, frame_bytes, out) != frame_bytes) {
+            perror(out_path);
+            return 1;
+        }
+        pthread_barrier_wait(&done_barrier);
+        rendered++;
+
+        if(stop_wall_frame && wall_frame >= stop_wall_frame && wall_frame - previous_wall_frame == 1) {
+            printf("%u\n", wall_frame);
+            break;
+        }
+    }
+    if(stop_wall_frame && wall_frame < stop_wall_frame) {
+        fprintf(stderr, "wall frame %u not reached in %u frames\n", stop_wall_frame, frames);
+        return 1;
+    }
+    // The last frame rendered (the only one when stopping at a wall frame)
+    if(rendered && fwrite(out_frames[(rendered - 1) & 1], 1, frame_bytes, out) != frame_bytes) {
+        perror(out_path);
+        return 1;
+    }
+
+    stop_workers = true;
+    pthread_barrier_wait(&start_barrier);
+    for(uint n = 0; n < thread_count; n++) {
+        pthread_join(workers[n], NULL);
+    }
+    fclose(out);
+    if(bus_out) {
+        fclose(bus_out);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double seconds = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+    fprintf(stderr, "%u frames of %ux%u in %.2f s (%.0f fps, %u threads)\n",
+            rendered, out_width, out_height, seconds, rendered / seconds, thread_count);
+    return 0;
+}
@@ -0,0 +1,72 @@
+#include "scanvideo_host.h"
+#include "pico/scanvideo/composable_scanline.h"
+
+void host_scanline_begin(host_scanline_t *line, uint32_t frame, uint16_t y) {
+    line->buffer.scanline_id = (frame << 16) | y;
+    line->buffer.data = line->data;
+    line->buffer.data_used = 0;
+    line->buffer.data_max = PICO_SCANVIDEO_MAX_SCANLINE_BUFFER_WORDS;
+    line->buffer.status = 0;
+}
+
+// Store a pixel if it is on screen (x counts every pixel, including overflow)
+static inline void put(uint16_t *pixels, uint width, uint *x, uint16_t color) {
+    if(*x < width) {
+        pixels[*x] = color;
+    }
+    (*x)++;
+}
+
+int scanvideo_host_decode(const scanvideo_scanline_buffer_t *buffer, uint16_t *pixels, uint width) {
+    const uint16_t *p = (const uint16_t *) buffer->data;
+    const uint16_t *end = p + 2 * buffer->data_used;
+    uint x = 0;
+
+    if(buffer->status != SCANLINE_OK || buffer->data_used > buffer->data_max) {
+        return -1;
+    }
+
+    while(p < end) {
+        uint16_t token = *p++;
+        switch(token) {
+            case COMPOSABLE_COLOR_RUN: {
+                uint16_t color = p[0];
+                uint count = p[1] + 3;
+                p += 2;
+                while(count--) {
+                    put(pixels, width, &x, color);
+                }
+                break;
+            }
+            case COMPOSABLE_RAW_RUN: {
+                put(pixels, width, &x, p[0]);
+                uint count = p[1] + 2;
+                p += 2;
+                while(count--) {
+                    put(pixels, width, &x, *p++);
+                }
+                break;
+            }
+            case COMPOSABLE_RAW_1P:
+                put(pixels, width, &x, *p++);
+                break;
+            case COMPOSABLE_RAW_1P_SKIP_ALIGN:
+                put(pixels, width, &x, *p++);
+                p++;
+                break;
+            case COMPOSABLE_RAW_2P:
+                put(pixels, width, &x, *p++);
+                put(pixels, width, &x, *p++);
+                break;
+            case COMPOSABLE_EOL_ALIGN:
+            case COMPOSABLE_EOL_SKIP_ALIGN:
+                // Lines end with a black pixel to stop color bleeding into blanking
+                return (x > 0) ? (int)x - 1 : -1;
+            default:
+                return -1;
+        }
+    }
+
+    // Ran off the end without an end of line token
+    return -1;
+}
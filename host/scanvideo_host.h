@@ -0,0 +1,32 @@
+// Host decoder for composable scanline buffers
+
+#ifndef SCANVIDEO_HOST_H
+#define SCANVIDEO_HOST_H
+
+#include "pico/scanvideo.h"
+
+// Scanline buffer with its own storage, sized like the device's
+typedef struct {
+    scanvideo_scanline_buffer_t buffer;
+    uint32_t data[PICO_SCANVIDEO_MAX_SCANLINE_BUFFER_WORDS];
+} host_scanline_t;
+
+// Reset a line for frame/line before drawing into it
+void host_scanline_begin(host_scanline_t *line, uint32_t frame, uint16_t y);
+
+// Decode a finished line into width RGB555 pixels (the closing black pixel is
+// dropped). Returns the number of pixels the tokens described excluding that
+// pixel, or -1 if the token stream is malformed.
+int scanvideo_host_decode(const scanvideo_scanline_buffer_t *buffer, uint16_t *pixels, uint width);
+
+// Expand an RGB555 pixel to 8-bit RGB
+static inline void scanvideo_host_rgb8(uint16_t pixel, uint8_t *rgb) {
+    uint8_t r = PICO_SCANVIDEO_R5_FROM_PIXEL(pixel);
+    uint8_t g = PICO_SCANVIDEO_G5_FROM_PIXEL(pixel);
+    uint8_t b = PICO_SCANVIDEO_B5_FROM_PIXEL(pixel);
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 3) | (g >> 2);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+
+#endif
@@ -0,0 +1,47 @@
+# Video wall drift check (ctest, run with cmake -P)
+#
+# Renders tile 0 of a 2x1 wall to record its sync line, then tile 1 twice: once
+# with its clock DRIFT parts per million off, stopped at wall frame FRAME (see
+# -w in render.c), and once on time stopped at the wall frame the first run
+# reached. The two must match, so a follower that catches up several frames at
+# once has stepped its effects as far as one that never fell behind.
+#
+# cmake -DRENDER=<render> -DDIR=<scratch dir> -DDRIFT=<ppm> -DFRAME=<n>
+#       -DPARAMS=demo=10,... -P wall_drift.cmake
+
+string(REPLACE "," ";" PARAMS ${PARAMS})
+set(params)
+foreach(param ${PARAMS})
+    list(APPEND params -p ${param})
+endforeach()
+list(APPEND params -p wall_columns=2 -p wall_rows=1)
+math(EXPR frames "${FRAME} * 2")
+
+file(MAKE_DIRECTORY ${DIR})
+execute_process(
+    COMMAND ${RENDER} -o ${DIR}/leader.rgb -n ${frames} -b ${DIR}/bus.txt ${params} -p wall_tile=0
+    RESULT_VARIABLE result ERROR_QUIET)
+if(result)
+    message(FATAL_ERROR "leader render failed")
+endif()
+
+execute_process(
+    COMMAND ${RENDER} -o ${DIR}/drift.rgb -n ${frames} -w ${FRAME} -d ${DRIFT} -b ${DIR}/bus.txt ${params} -p wall_tile=1
+    RESULT_VARIABLE result OUTPUT_VARIABLE reached OUTPUT_STRIP_TRAILING_WHITESPACE ERROR_QUIET)
+if(result)
+    message(FATAL_ERROR "drifting follower render failed")
+endif()
+
+execute_process(
+    COMMAND ${RENDER} -o ${DIR}/steady.rgb -n ${frames} -w ${reached} -b ${DIR}/bus.txt ${params} -p wall_tile=1
+    RESULT_VARIABLE result ERROR_QUIET OUTPUT_QUIET)
+if(result)
+    message(FATAL_ERROR "steady follower render failed")
+endif()
+
+execute_process(
+    COMMAND ${CMAKE_COMMAND} -E compare_files ${DIR}/drift.rgb ${DIR}/steady.rgb
+    RESULT_VARIABLE result)
+if(result)
+    message(FATAL_ERROR "follower drifting ${DRIFT} ppm differs from one on time at wall frame ${reached}")
+endif()
@@ -0,0 +1,52 @@
+# Video wall parameter sharing check (ctest, run with cmake -P)
+#
+# Renders tile 0 of a 2x1 wall with the pots moving and LEADER parameters set,
+# then tile 1 twice: once with other parameters and pots of its own, once with
+# the leader's. The leader's parameters and pots reach the follower with the
+# frame sync, so the two must match.
+#
+# cmake -DRENDER=<render> -DDIR=<scratch dir> -DLEADER=demo=4,... -DOTHER=demo=13,...
+#       -P wall_params.cmake
+
+function(param_args var list)
+    string(REPLACE "," ";" list ${list})
+    set(args)
+    foreach(param ${list})
+        list(APPEND args -p ${param})
+    endforeach()
+    set(${var} ${args} -p wall_columns=2 -p wall_rows=1 PARENT_SCOPE)
+endfunction()
+param_args(leader ${LEADER})
+param_args(other ${OTHER})
+
+file(MAKE_DIRECTORY ${DIR})
+file(WRITE ${DIR}/leader.txt "0 0 0\n40 4095 2000\n80 1000 4095\n")
+file(WRITE ${DIR}/other.txt "0 3000 500\n")
+
+execute_process(
+    COMMAND ${RENDER} -o ${DIR}/leader.rgb -n 120 -a ${DIR}/leader.txt -b ${DIR}/bus.txt ${leader} -p wall_tile=0
+    RESULT_VARIABLE result ERROR_QUIET)
+if(result)
+    message(FATAL_ERROR "leader render failed")
+endif()
+
+execute_process(
+    COMMAND ${RENDER} -o ${DIR}/same.rgb -n 120 -a ${DIR}/leader.txt -b ${DIR}/bus.txt ${leader} -p wall_tile=1
+    RESULT_VARIABLE result ERROR_QUIET)
+if(result)
+    message(FATAL_ERROR "follower render failed")
+endif()
+
+execute_process(
+    COMMAND ${RENDER} -o ${DIR}/other.rgb -n 120 -a ${DIR}/other.txt -b ${DIR}/bus.txt ${other} -p wall_tile=1
+    RESULT_VARIABLE result ERROR_QUIET)
+if(result)
+    message(FATAL_ERROR "follower render with its own parameters failed")
+endif()
+
+execute_process(
+    COMMAND ${CMAKE_COMMAND} -E compare_files ${DIR}/same.rgb ${DIR}/other.rgb
+    RESULT_VARIABLE result)
+if(result)
+    message(FATAL_ERROR "follower with its own parameters and pots differs from one with the leader's")
+endif()